@@ -0,0 +1,62 @@
+/**    :       (setLargePayload).
+ *  (Linux): g++ -std=gnu++11 -O2 -pthread bench_payload.cpp logs.cpp -o bench_payload
+ * : bench_payload [  ].  : 256
+ *   4  ... 1    copy ( 0 -      ),
+ * split ( 4  -    ,   pwritev  )  shared
+ * (LogPayload -     ,  )     write() ()
+ *       (flush), /.
+ */
+#include <iostream>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "logs.h"
+using namespace std;
+
+typedef chrono::steady_clock clock_type;
+
+/**  : count   size
+ * @param mode - 0 - copy, 1 - split, 2 - shared
+ * @return  (  , /   flush)
+*/
+static pair<double, double> run(int mode, size_t size, long count) {
+    remove("bench_payload.log");
+    Logs log;
+    log.setOutput(Logs::only_file);
+    log.setLevel(Logs::Severity::trace);
+    log.setAsync(true);
+    log.setLargePayload(mode == 0 ? 0 : 4096);
+    string text(size, 'x');
+    shared_ptr<const string> shared = make_shared<const string>(text);
+    clock_type::time_point start = clock_type::now();
+    for (long i = 0; i < count; i++) {
+        if (mode == 2) log.write(Logs::Severity::info, LogPayload(shared), "bench_payload.log");
+        else log.write(Logs::Severity::info, text, "bench_payload.log");
+    }
+    double perCall = chrono::duration<double, micro>(clock_type::now() - start).count() / count;
+    log.flush();
+    double total = chrono::duration<double>(clock_type::now() - start).count();
+    log.setAsync(false);
+    return make_pair(perCall, (double)size * count / total / (1 << 20));
+}
+
+int main(int argc, char** argv) {
+    long megabytes = argc > 1 ? atol(argv[1]) : 256;
+    const char* modes[] = {"copy", "split", "shared"};
+    size_t sizes[] = {4 << 10, 16 << 10, 64 << 10, 256 << 10, 1 << 20};
+
+    printf("%-8s %10s %12s %12s\n", "mode", "size", "us/call", "MB/s disk");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        long count = (long)((megabytes << 20) / sizes[s]);
+        if (count < 1) count = 1;
+        for (int m = 0; m < 3; m++) {
+            pair<double, double> r = run(m, sizes[s], count);
+            printf("%-8s %9zuK %12.2f %12.1f\n", modes[m], sizes[s] >> 10, r.first, r.second);
+            fflush(stdout);
+        }
+    }
+    remove("bench_payload.log");
+    return 0;
+}
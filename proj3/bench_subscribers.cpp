@@ -0,0 +1,116 @@
+/**        .
+ *  (Linux): g++ -std=gnu++11 -O2 -pthread bench_subscribers.cpp logs.cpp -o bench_subscribers
+ * : bench_subscribers [  ] [].  : 200000 4
+ *     ;    ,  - 
+ *   ,  - ,     50 .
+ *        ,     -  
+ * ,    (     ).
+ *   1,     ,   .
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "logs.h"
+using namespace std;
+
+typedef chrono::steady_clock clock_type;
+
+/**     */
+struct Consumer {
+    const char* name;
+    shared_ptr<Logs::Subscription> subscription;
+    int delayUs;
+    unsigned long long seen;
+    unsigned long long errors;
+    thread worker;
+};
+
+/**  : "w<> n<>",   -   "timeout" */
+static double produce(Logs& log, int threads, long count) {
+    vector<thread> workers;
+    clock_type::time_point start = clock_type::now();
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&log, t, count]() {
+            for (long i = 0; i < count; i++) {
+                string text = "w" + to_string(t) + " n" + to_string(i);
+                if (i % 100 == 0) log.write(Logs::Severity::warning, text + " timeout", "bench_subscribers");
+                else log.write(Logs::Severity::info, text, "bench_subscribers");
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+/**    ;       */
+static void consume(Consumer* c, atomic<bool>* stop, int threads) {
+    vector<long> last(threads, -1);
+    Logs::Record r;
+    while (true) {
+        if (!c->subscription->wait(r, 10)) {
+            if (*stop) break;
+            continue;
+        }
+        c->seen++;
+        int t = atoi(r.text.c_str() + 1);
+        long n = atol(r.text.c_str() + r.text.find(" n") + 2);
+        if (t < 0 || t >= threads || n <= last[t]) c->errors++;
+        else last[t] = n;
+        if (c->subscription->filter().level == Logs::Severity::warning && r.text.find("timeout") == string::npos) c->errors++;
+        if (c->delayUs) this_thread::sleep_for(chrono::microseconds(c->delayUs));
+    }
+}
+
+int main(int argc, char** argv) {
+    long count = argc > 1 ? atol(argv[1]) : 200000;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+    double records = (double)threads * count;
+
+    remove("bench_subscribers.log");
+    double plain;
+    {
+        Logs log;
+        log.setOutput(Logs::only_file);
+        log.setLevel(Logs::Severity::trace);
+        log.setAsync(true);
+        plain = produce(log, threads, count);
+        log.flush();
+    }
+    printf("without subscribers: %.2f Mrec/s\n", records / plain / 1e6);
+
+    remove("bench_subscribers.log");
+    Logs log;
+    log.setOutput(Logs::only_file);
+    log.setLevel(Logs::Severity::trace);
+    Consumer consumers[3] = {
+        {"all", log.subscribe(Logs::Filter(), 1 << 16), 0, 0, 0, thread()},
+        {"warnings", log.subscribe(Logs::Filter(Logs::Severity::warning, "bench_subscribers", "timeout")), 0, 0, 0, thread()},
+        {"slow", log.subscribe(Logs::Filter(), 1024), 50, 0, 0, thread()}
+    };
+    atomic<bool> stop(false);
+    for (int i = 0; i < 3; i++) consumers[i].worker = thread(consume, &consumers[i], &stop, threads);
+    double loaded = produce(log, threads, count);
+    log.flush();
+    stop = true;
+    for (int i = 0; i < 3; i++) consumers[i].worker.join();
+    printf("with 3 subscribers:  %.2f Mrec/s\n", records / loaded / 1e6);
+
+    int status = 0;
+    unsigned long long warnings = (unsigned long long)threads * ((count + 99) / 100);
+    printf("%-10s %12s %12s %12s\n", "subscriber", "received", "dropped", "errors");
+    for (int i = 0; i < 3; i++) {
+        Consumer& c = consumers[i];
+        printf("%-10s %12llu %12llu %12llu\n", c.name, c.subscription->received(), c.subscription->dropped(), c.errors);
+        if (c.errors || c.seen != c.subscription->received()) status = 1;
+        log.unsubscribe(c.subscription);
+    }
+    //         
+    if (consumers[1].subscription->received() + consumers[1].subscription->dropped() != warnings) status = 1;
+    remove("bench_subscribers.log");
+    return status;
+}
@@ -0,0 +1,66 @@
+/**       :     .
+ *  (Linux): g++ -std=gnu++11 -O2 -pthread bench_threads.cpp logs.cpp -o bench_threads
+ * : bench_threads [  ] [ ].  : 200000 64
+ *       (1, 2, 4 ... ) :
+ *    write()   (),          (flush).
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "logs.h"
+using namespace std;
+
+typedef chrono::steady_clock clock_type;
+
+/**  : threads    count 
+ * @return  (      ,     flush  )
+*/
+static pair<double, double> run(Logs& log, int threads, long count) {
+    vector<thread> workers;
+    vector<double> perCall(threads);
+    clock_type::time_point start = clock_type::now();
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&log, &perCall, t, count]() {
+            string text = "thread " + to_string(t) + " benchmark message with some payload";
+            clock_type::time_point begin = clock_type::now();
+            for (long i = 0; i < count; i++) log.write(Logs::Severity::info, text, "bench_threads.log");
+            perCall[t] = chrono::duration<double, nano>(clock_type::now() - begin).count() / count;
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    log.flush();
+    double total = chrono::duration<double>(clock_type::now() - start).count();
+    double sum = 0;
+    for (int t = 0; t < threads; t++) sum += perCall[t];
+    return make_pair(sum / threads, total);
+}
+
+int main(int argc, char** argv) {
+    long count = argc > 1 ? atol(argv[1]) : 200000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 64;
+    const char* modes[] = {"queue", "thread_local"};
+
+    printf("%-13s %8s %12s %14s %14s\n", "mode", "threads", "ns/call", "Mrec/s enq", "Mrec/s disk");
+    for (int m = 0; m < 2; m++) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            remove("bench_threads.log");
+            Logs log;
+            log.setOutput(Logs::only_file);
+            log.setLevel(Logs::Severity::trace);
+            log.setAsync(true);
+            if (m == 1) log.setThreadLocal(true);
+            pair<double, double> r = run(log, threads, count);
+            double records = (double)threads * count;
+            printf("%-13s %8d %12.1f %14.2f %14.2f\n", modes[m], threads, r.first,
+                   threads * 1e3 / r.first, records / r.second / 1e6);
+            fflush(stdout);
+            log.setAsync(false);
+        }
+    }
+    remove("bench_threads.log");
+    return 0;
+}
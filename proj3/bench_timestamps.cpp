@@ -0,0 +1,78 @@
+/**      :      LogClock.
+ *  (Linux): g++ -std=gnu++11 -O2 -pthread bench_timestamps.cpp logs.cpp -o bench_timestamps
+ * : bench_timestamps [].  : 5000000
+ *     : getDatetime() (time + localtime + strftime), system_clock::now(),
+ * LogClock::ticks()     ;  write()    
+ *      ,      .
+ *    -   write()     .
+ */
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include "logs.h"
+#include "log_clock.h"
+using namespace std;
+
+typedef chrono::steady_clock clock_type;
+
+/**     f   */
+template <typename F>
+static double measure(long count, F f) {
+    clock_type::time_point start = clock_type::now();
+    for (long i = 0; i < count; i++) f();
+    return chrono::duration<double, nano>(clock_type::now() - start).count() / count;
+}
+
+/**     write()     */
+static double writeCost(long count, bool fast) {
+    remove("bench_timestamps.log");
+    Logs log;
+    log.setOutput(Logs::only_file);
+    log.setLevel(Logs::Severity::trace);
+    log.setThreadLocal(true, 1 << 16);
+    log.setFastTimestamps(fast);
+    string text = "benchmark message with some payload";
+    string file = "bench_timestamps.log";
+    double ns = measure(count, [&]() { log.write(Logs::Severity::info, text, file); });
+    log.setAsync(false);
+    return ns;
+}
+
+int main(int argc, char** argv) {
+    long count = argc > 1 ? atol(argv[1]) : 5000000;
+    volatile unsigned long long sink = 0;
+    Logs log;
+
+    printf("source: %s\n", LogClock::sourceName());
+    printf("%-28s %10.1f ns\n", "getDatetime(\"%X\")", measure(count / 10, [&]() { sink += log.getDatetime("%X").size(); }));
+    printf("%-28s %10.1f ns\n", "system_clock::now()", measure(count, [&]() {
+        sink += (unsigned long long)chrono::system_clock::now().time_since_epoch().count();
+    }));
+    printf("%-28s %10.1f ns\n", "LogClock::ticks()", measure(count, [&]() { sink += LogClock::ticks(); }));
+    LogClock clock;
+    unsigned long long stamp = LogClock::ticks();
+    printf("%-28s %10.1f ns\n", "LogClock::toTime()", measure(count, [&]() {
+        sink += (unsigned long long)clock.toTime(stamp + sink % 7).time_since_epoch().count();
+    }));
+
+    long writes = count / 5;
+    printf("%-28s %10.1f ns\n", "write(), system clock", writeCost(writes, false));
+    printf("%-28s %10.1f ns\n", "write(), fast timestamps", writeCost(writes, true));
+
+    //       
+    this_thread::sleep_for(chrono::seconds(1));
+    clock.calibrate();
+    long long worst = 0;
+    for (int i = 0; i < 1000; i++) {
+        long long real = (long long)chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        long long converted = clock.toNanoseconds(LogClock::ticks());
+        long long diff = converted > real ? converted - real : real - converted;
+        if (diff > worst) worst = diff;
+    }
+    printf("%-28s %10.1f us (%.4f ns/tick)\n", "max conversion error", worst / 1e3, clock.nsPerTick());
+    remove("bench_timestamps.log");
+    return sink == 42 ? 1 : 0;
+}
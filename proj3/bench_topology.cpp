@@ -0,0 +1,83 @@
+/**           .
+ *  (Linux): g++ -std=gnu++11 -O2 -pthread bench_topology.cpp logs.cpp -o bench_topology
+ * : bench_topology [  ] [ ] [].  : 200000 64 0
+ * : 0 -   NUMA, N -    N  (       ).
+ * :  ;  ;     ,   
+ * ,   ,      .
+ *       (1, 2, 4 ... ) :
+ *    write()   (),          (flush).
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "logs.h"
+#include "log_topology.h"
+using namespace std;
+
+typedef chrono::steady_clock clock_type;
+
+/**  : threads    count 
+ * @param workerCpus -       ;  -  
+ * @return  (      ,     flush  )
+*/
+static pair<double, double> run(Logs& log, int threads, long count, const vector<int>& workerCpus) {
+    vector<thread> workers;
+    vector<double> perCall(threads);
+    clock_type::time_point start = clock_type::now();
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&log, &perCall, &workerCpus, t, count]() {
+            if (!workerCpus.empty()) LogTopology::pinCurrentThread(vector<int>(1, workerCpus[t % workerCpus.size()]));
+            string text = "thread " + to_string(t) + " benchmark message with some payload";
+            clock_type::time_point begin = clock_type::now();
+            for (long i = 0; i < count; i++) log.write(Logs::Severity::info, text, "bench_topology.log");
+            perCall[t] = chrono::duration<double, nano>(clock_type::now() - begin).count() / count;
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    log.flush();
+    double total = chrono::duration<double>(clock_type::now() - start).count();
+    double sum = 0;
+    for (int t = 0; t < threads; t++) sum += perCall[t];
+    return make_pair(sum / threads, total);
+}
+
+int main(int argc, char** argv) {
+    long count = argc > 1 ? atol(argv[1]) : 200000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 64;
+    int groups = argc > 3 ? atoi(argv[3]) : 0;
+    const char* modes[] = {"queue", "node", "node_pinned"};
+
+    LogTopology topology(groups);
+    int cpus = (int)thread::hardware_concurrency();
+    if (cpus <= 0) cpus = 1;
+    printf("cpus: %d, groups: %d\n", cpus, (int)topology.size());
+    //   -  ,  -  (   -   )
+    vector<int> backendCpus(1, cpus - 1);
+    vector<int> workerCpus;
+    for (int cpu = 0; cpu < (cpus > 1 ? cpus - 1 : 1); cpu++) workerCpus.push_back(cpu);
+
+    printf("%-13s %8s %12s %14s %14s\n", "mode", "threads", "ns/call", "Mrec/s enq", "Mrec/s disk");
+    for (int m = 0; m < 3; m++) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            remove("bench_topology.log");
+            Logs log;
+            log.setOutput(Logs::only_file);
+            log.setLevel(Logs::Severity::trace);
+            log.setAsync(true);
+            if (m == 1) log.setTopology(true, groups);
+            if (m == 2) log.setTopology(true, groups, backendCpus);
+            pair<double, double> r = run(log, threads, count, m == 2 ? workerCpus : vector<int>());
+            double records = (double)threads * count;
+            printf("%-13s %8d %12.1f %14.2f %14.2f\n", modes[m], threads, r.first,
+                   threads * 1e3 / r.first, records / r.second / 1e6);
+            fflush(stdout);
+            log.setAsync(false);
+        }
+    }
+    remove("bench_topology.log");
+    return 0;
+}
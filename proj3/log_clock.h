@@ -0,0 +1,162 @@
+#ifndef LOG_CLOCK_H
+#define LOG_CLOCK_H
+
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LOG_CLOCK_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#endif
+using namespace std;
+
+/**       .
+ * ,  ,   ""  ticks():  x86   TSC -
+ * rdtsc ( ),  CLOCK_MONOTONIC_COARSE (Linux)   .
+ *         toTime()  
+ *  -> ,     calibrate().
+ *   -DLOG_CLOCK_NO_TSC  TSC (,    ).
+ */
+class LogClock {
+public:
+    /**    */
+    enum Source {source_tsc, source_monotonic_coarse, source_realtime};
+
+    /** ,     (  ) */
+    static Source source() {
+        static const Source s = detectSource();
+        return s;
+    }
+
+    /**    ( -) */
+    static unsigned long long ticks() {
+#ifdef LOG_CLOCK_X86
+        if (source() == source_tsc) return __rdtsc();
+#endif
+#if defined(CLOCK_MONOTONIC_COARSE)
+        if (source() == source_monotonic_coarse) {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+        }
+#endif
+        return (unsigned long long)chrono::duration_cast<chrono::nanoseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /**  ;  TSC   5  */
+    LogClock() : m_firstTicks(0), m_firstNs(0), m_baseTicks(0), m_baseNs(0), m_nsPerTick(1.0) {
+        sample(m_firstTicks, m_firstNs);
+        if (source() == source_tsc) {
+            //  TSC      ,   calibrate()
+            unsigned long long t = 0;
+            long long ns = 0;
+            do {
+                sample(t, ns);
+            } while (ns - m_firstNs < 5000000);
+            m_nsPerTick = (double)(ns - m_firstNs) / (double)(t - m_firstTicks);
+        }
+        m_baseTicks = m_firstTicks;
+        m_baseNs = m_firstNs;
+    }
+
+    /**   (  ,    ).
+     *        ,      -
+     *     ,    .
+    */
+    void calibrate() {
+        unsigned long long t = 0;
+        long long ns = 0;
+        sample(t, ns);
+        if (source() == source_tsc && t > m_firstTicks + 1000000) {
+            m_nsPerTick = (double)(ns - m_firstNs) / (double)(t - m_firstTicks);
+        }
+        m_baseTicks = t;
+        m_baseNs = ns;
+    }
+
+    /**        (  ) */
+    long long toNanoseconds(unsigned long long stamp) const {
+        if (source() == source_realtime) return (long long)stamp;
+        long long delta = (long long)(stamp - m_baseTicks);
+        return m_baseNs + (long long)((double)delta * m_nsPerTick);
+    }
+
+    /**        */
+    chrono::system_clock::time_point toTime(unsigned long long stamp) const {
+        return chrono::system_clock::time_point(chrono::duration_cast<chrono::system_clock::duration>(
+            chrono::nanoseconds(toNanoseconds(stamp))));
+    }
+
+    /**      ( TSC -  ) */
+    double nsPerTick() const {
+        return m_nsPerTick;
+    }
+
+    static const char* sourceName() {
+        switch (source()) {
+        case source_tsc: return "tsc";
+        case source_monotonic_coarse: return "monotonic_coarse";
+        default: return "realtime";
+        }
+    }
+
+private:
+    unsigned long long m_firstTicks;
+    long long m_firstNs;
+    unsigned long long m_baseTicks;
+    long long m_baseNs;
+    double m_nsPerTick;
+
+    static long long realtimeNs() {
+        return (long long)chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /**  (,  );         */
+    static void sample(unsigned long long& stamp, long long& ns) {
+        unsigned long long best = ~0ULL;
+        stamp = 0;
+        ns = 0;
+        for (int i = 0; i < 3; i++) {
+            unsigned long long before = ticks();
+            long long now = realtimeNs();
+            unsigned long long after = ticks();
+            if (after - before < best) {
+                best = after - before;
+                stamp = before + (after - before) / 2;
+                ns = now;
+            }
+        }
+    }
+
+    /** TSC ,     (      ) */
+    static Source detectSource() {
+#if defined(LOG_CLOCK_X86) && !defined(LOG_CLOCK_NO_TSC) && !defined(_MSC_VER)
+        unsigned eax, ebx, ecx, edx;
+        if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) && eax >= 0x80000007) {
+            __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+            if (edx & (1u << 8)) return source_tsc;
+        }
+#elif defined(LOG_CLOCK_X86) && !defined(LOG_CLOCK_NO_TSC)
+        int info[4];
+        __cpuid(info, 0x80000000);
+        if ((unsigned)info[0] >= 0x80000007) {
+            __cpuid(info, 0x80000007);
+            if (info[3] & (1 << 8)) return source_tsc;
+        }
+#endif
+#if defined(CLOCK_MONOTONIC_COARSE)
+        return source_monotonic_coarse;
+#else
+        return source_realtime;
+#endif
+    }
+};
+
+#endif // LOG_CLOCK_H
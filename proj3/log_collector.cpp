@@ -0,0 +1,202 @@
+/**         NetworkSink.
+ *  (Linux): g++ -std=gnu++11 -O2 log_collector.cpp -o log_collector
+ * : log_collector [-p udp|syslog|framed] [-port 5140] [-o ] [-t ]
+ *  -p     - : udp (syslog_udp), syslog (syslog_tcp), framed (framed_tcp).  : framed
+ *  -port  - .  : 5140
+ *  -o     -     .  :  
+ *  -t     -    .  :  Ctrl+C
+ *      ,   - .
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+using namespace std;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void onSignal(int) {
+    g_stop = 1;
+}
+
+/**  TCP     */
+struct Client {
+    int fd;
+    string buffer;
+};
+
+/**   */
+struct Stats {
+    unsigned long long records;
+    unsigned long long bytes;
+    unsigned long long frames;
+};
+
+/**      */
+static void store(FILE* out, const char* data, size_t len) {
+    if (out == nullptr) return;
+    fwrite(data, 1, len, out);
+    if (len == 0 || data[len - 1] != '\n') fputc('\n', out);
+}
+
+/**   syslog   : "  " */
+static void parseSyslog(Client& c, Stats& st, FILE* out) {
+    size_t pos = 0;
+    while (true) {
+        size_t sp = c.buffer.find(' ', pos);
+        if (sp == string::npos) break;
+        size_t len = strtoul(c.buffer.c_str() + pos, nullptr, 10);
+        if (c.buffer.size() - sp - 1 < len) break;
+        store(out, c.buffer.data() + sp + 1, len);
+        st.records++;
+        st.frames++;
+        pos = sp + 1 + len;
+    }
+    c.buffer.erase(0, pos);
+}
+
+/**  : 4   (big-endian) +   */
+static void parseFramed(Client& c, Stats& st, FILE* out) {
+    size_t pos = 0;
+    while (c.buffer.size() - pos >= 4) {
+        const unsigned char* p = (const unsigned char*)c.buffer.data() + pos;
+        size_t len = ((size_t)p[0] << 24) | ((size_t)p[1] << 16) | ((size_t)p[2] << 8) | p[3];
+        if (c.buffer.size() - pos - 4 < len) break;
+        const char* body = c.buffer.data() + pos + 4;
+        for (size_t i = 0; i < len; i++) if (body[i] == '\n') st.records++;
+        if (out) fwrite(body, 1, len, out);
+        st.frames++;
+        pos += 4 + len;
+    }
+    c.buffer.erase(0, pos);
+}
+
+int main(int argc, char** argv) {
+    string protocol = "framed";
+    int port = 5140;
+    string outFile;
+    double duration = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string key = argv[i];
+        if (key == "-p") protocol = argv[i + 1];
+        else if (key == "-port") port = atoi(argv[i + 1]);
+        else if (key == "-o") outFile = argv[i + 1];
+        else if (key == "-t") duration = atof(argv[i + 1]);
+    }
+    bool udp = (protocol == "udp");
+    if (!udp && protocol != "syslog" && protocol != "framed") {
+        cerr << "unknown protocol: " << protocol << endl;
+        return 2;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    int lfd = socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    int rcvbuf = 8 << 20;
+    setsockopt(lfd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(lfd, (sockaddr*)&addr, sizeof(addr)) != 0 || (!udp && listen(lfd, 16) != 0)) {
+        perror("bind/listen");
+        return 1;
+    }
+
+    FILE* out = nullptr;
+    if (!outFile.empty()) {
+        out = fopen(outFile.c_str(), "ab");
+        if (out == nullptr) {
+            perror("fopen");
+            return 1;
+        }
+    }
+
+    cout << "listening: " << protocol << " port " << port << endl;
+    Stats st = {0, 0, 0};
+    Stats last = st;
+    vector<Client> clients;
+    vector<char> buf(1 << 16);
+    typedef chrono::steady_clock clock_type;
+    clock_type::time_point start = clock_type::now();
+    clock_type::time_point tick = start;
+
+    while (!g_stop) {
+        vector<pollfd> fds(1 + clients.size());
+        fds[0].fd = lfd;
+        fds[0].events = POLLIN;
+        for (size_t i = 0; i < clients.size(); i++) {
+            fds[i + 1].fd = clients[i].fd;
+            fds[i + 1].events = POLLIN;
+        }
+        poll(fds.data(), fds.size(), 100);
+
+        if (fds[0].revents & POLLIN) {
+            if (udp) {
+                //   ,   
+                ssize_t n;
+                while ((n = recv(lfd, buf.data(), buf.size(), MSG_DONTWAIT)) > 0) {
+                    store(out, buf.data(), (size_t)n);
+                    st.records++;
+                    st.frames++;
+                    st.bytes += n;
+                }
+            }
+            else {
+                int cfd = accept(lfd, nullptr, nullptr);
+                if (cfd >= 0) {
+                    Client c;
+                    c.fd = cfd;
+                    clients.push_back(c);
+                }
+            }
+        }
+        for (size_t i = 0; i < clients.size(); i++) {
+            if (!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            ssize_t n = recv(clients[i].fd, buf.data(), buf.size(), 0);
+            if (n <= 0) {
+                close(clients[i].fd);
+                clients[i].fd = -1;
+                continue;
+            }
+            st.bytes += n;
+            clients[i].buffer.append(buf.data(), (size_t)n);
+            if (protocol == "syslog") parseSyslog(clients[i], st, out);
+            else parseFramed(clients[i], st, out);
+        }
+        for (size_t i = clients.size(); i-- > 0;) {
+            if (clients[i].fd < 0) clients.erase(clients.begin() + i);
+        }
+
+        clock_type::time_point now = clock_type::now();
+        if (now - tick >= chrono::seconds(1)) {
+            double sec = chrono::duration<double>(now - tick).count();
+            printf("records/s: %.0f  MB/s: %.2f  total records: %llu\n",
+                   (st.records - last.records) / sec, (st.bytes - last.bytes) / sec / 1e6, st.records);
+            fflush(stdout);
+            last = st;
+            tick = now;
+        }
+        if (duration > 0 && chrono::duration<double>(now - start).count() >= duration) break;
+    }
+
+    double total = chrono::duration<double>(clock_type::now() - start).count();
+    printf("total: records %llu, frames %llu, bytes %llu, %.2f s\n", st.records, st.frames, st.bytes, total);
+    for (size_t i = 0; i < clients.size(); i++) close(clients[i].fd);
+    close(lfd);
+    if (out) fclose(out);
+    return 0;
+}
@@ -0,0 +1,365 @@
+#ifndef LOG_COMPRESS_H
+#define LOG_COMPRESS_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include "log_sink.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef LOG_USE_ZSTD
+#include <zstd.h>
+#endif
+using namespace std;
+
+/**     */
+enum class LogCompression {none, lz4, zstd};
+
+/**     LZ4 (  ).
+ *      LZ4 Frame -  ,   
+ *    : lz4 -d file.log.lz4
+ */
+class Lz4FrameWriter {
+public:
+    /** @param blockSize -     (  4 )
+     * @param level - 1..6:  ,      ( ,  )
+    */
+    Lz4FrameWriter(size_t blockSize, int level) {
+        if (level < 1) level = 1;
+        if (level > 6) level = 6;
+        m_hashLog = 10 + level;
+        m_table.resize((size_t)1 << m_hashLog);
+        //       : 4 - 64 , 5 - 256 , 6 - 1 , 7 - 4 
+        m_blockCode = 4;
+        while (m_blockCode < 7 && ((size_t)1 << (8 + 2 * m_blockCode)) < blockSize) m_blockCode++;
+    }
+
+    /**        len */
+    static size_t frameBound(size_t len) {
+        return len + len / 255 + 32;
+    }
+
+    /**      (   -     )
+     * @param src -  
+     * @param len -  (  blockSize)
+     * @param dst -     frameBound(len)
+     * @return  
+    */
+    size_t compressFrame(const char* src, size_t len, char* dst) {
+        unsigned char* out = (unsigned char*)dst;
+        size_t pos = 0;
+        writeLE32(out, 0x184D2204);          //   
+        pos += 4;
+        out[pos++] = 0x60;                   //  01,  ,    
+        out[pos++] = (unsigned char)(m_blockCode << 4);
+        out[pos] = (unsigned char)((xxh32(out + 4, 2, 0) >> 8) & 0xFF);
+        pos++;
+        if (len > 0) {
+            size_t compressed = compressBlock((const unsigned char*)src, len, out + pos + 4);
+            if (compressed >= len) {
+                //      (  )
+                writeLE32(out + pos, (uint32_t)len | 0x80000000U);
+                memcpy(out + pos + 4, src, len);
+                pos += 4 + len;
+            }
+            else {
+                writeLE32(out + pos, (uint32_t)compressed);
+                pos += 4 + compressed;
+            }
+        }
+        writeLE32(out + pos, 0);             //  
+        return pos + 4;
+    }
+
+private:
+    vector<uint32_t> m_table;
+    int m_hashLog;
+    int m_blockCode;
+
+    static uint32_t readLE32(const unsigned char* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static void writeLE32(unsigned char* p, uint32_t v) {
+        p[0] = (unsigned char)v;
+        p[1] = (unsigned char)(v >> 8);
+        p[2] = (unsigned char)(v >> 16);
+        p[3] = (unsigned char)(v >> 24);
+    }
+
+    static uint32_t rotl(uint32_t x, int r) {
+        return (x << r) | (x >> (32 - r));
+    }
+
+    /** XXH32 -       */
+    static uint32_t xxh32(const unsigned char* p, size_t len, uint32_t seed) {
+        const uint32_t p1 = 2654435761U, p2 = 2246822519U, p3 = 3266489917U, p4 = 668265263U, p5 = 374761393U;
+        const unsigned char* end = p + len;
+        uint32_t h;
+        if (len >= 16) {
+            uint32_t v1 = seed + p1 + p2, v2 = seed + p2, v3 = seed, v4 = seed - p1;
+            for (; p + 16 <= end; p += 16) {
+                v1 = rotl(v1 + readLE32(p) * p2, 13) * p1;
+                v2 = rotl(v2 + readLE32(p + 4) * p2, 13) * p1;
+                v3 = rotl(v3 + readLE32(p + 8) * p2, 13) * p1;
+                v4 = rotl(v4 + readLE32(p + 12) * p2, 13) * p1;
+            }
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        }
+        else {
+            h = seed + p5;
+        }
+        h += (uint32_t)len;
+        for (; p + 4 <= end; p += 4) h = rotl(h + readLE32(p) * p3, 17) * p4;
+        for (; p < end; p++) h = rotl(h + (*p) * p5, 11) * p1;
+        h ^= h >> 15;
+        h *= p2;
+        h ^= h >> 13;
+        h *= p3;
+        h ^= h >> 16;
+        return h;
+    }
+
+    uint32_t hash(uint32_t sequence) const {
+        return (sequence * 2654435761U) >> (32 - m_hashLog);
+    }
+
+    /**  ,    4   (  255) */
+    static unsigned char* writeLength(unsigned char* op, size_t len) {
+        for (; len >= 255; len -= 255) *op++ = 255;
+        *op++ = (unsigned char)len;
+        return op;
+    }
+
+    /**  LZ4: literals    anchor,   (offset, matchLength) */
+    static unsigned char* writeSequence(unsigned char* op, const unsigned char* anchor, size_t literals, size_t offset, size_t matchLength) {
+        unsigned char* token = op++;
+        *token = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+        if (literals >= 15) op = writeLength(op, literals - 15);
+        memcpy(op, anchor, literals);
+        op += literals;
+        if (matchLength == 0) return op;   //   -  
+        *op++ = (unsigned char)offset;
+        *op++ = (unsigned char)(offset >> 8);
+        size_t code = matchLength - 4;
+        *token |= (unsigned char)(code >= 15 ? 15 : code);
+        if (code >= 15) op = writeLength(op, code - 15);
+        return op;
+    }
+
+    /**     -  ( LZ4 Block)
+     * @return   
+    */
+    size_t compressBlock(const unsigned char* src, size_t len, unsigned char* dst) {
+        //    5  - ,        12   
+        const size_t lastLiterals = 5;
+        const size_t matchStartLimit = 12;
+        unsigned char* op = dst;
+        size_t anchor = 0;
+        if (len > matchStartLimit) {
+            //    + 1, 0 -  ;  ,  
+            memset(m_table.data(), 0, m_table.size() * sizeof(uint32_t));
+            size_t limit = len - matchStartLimit;
+            size_t matchLimit = len - lastLiterals;
+            size_t ip = 0;
+            while (ip < limit) {
+                uint32_t sequence = readLE32(src + ip);
+                uint32_t h = hash(sequence);
+                size_t ref = m_table[h];
+                m_table[h] = (uint32_t)ip + 1;
+                if (ref == 0 || ip - (ref - 1) > 65535 || readLE32(src + ref - 1) != sequence) {
+                    //     
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+                ref--;
+                while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                    ip--;
+                    ref--;
+                }
+                size_t matchLength = 4;
+                while (ip + matchLength < matchLimit && src[ip + matchLength] == src[ref + matchLength]) matchLength++;
+                op = writeSequence(op, src + anchor, ip - anchor, ip - ref, matchLength);
+                ip += matchLength;
+                anchor = ip;
+                if (ip - 2 < limit) m_table[hash(readLE32(src + ip - 2))] = (uint32_t)(ip - 2) + 1;
+            }
+        }
+        op = writeSequence(op, src + anchor, len - anchor, 0, 0);
+        return (size_t)(op - dst);
+    }
+};
+
+/**    :      ,  
+ * (  -  flush)       LZ4  zstd  
+ *  FileSink.  ,        .
+ * zstd     -DLOG_USE_ZSTD  -lzstd;    zstd  LZ4.
+ */
+class CompressedFileSink : public LogSink {
+private:
+    LogSink* m_file;
+    LogCompression m_codec;
+    size_t m_blockSize;
+    int m_level;
+    vector<char> m_block;
+    size_t m_used;
+    vector<char> m_frame;
+    Lz4FrameWriter m_lz4;
+    unsigned long long m_plainBytes;
+    unsigned long long m_compressedBytes;
+#ifdef LOG_USE_ZSTD
+    ZSTD_CCtx* m_zstd;
+#endif
+
+    /**  zstd    (  :   ) */
+    size_t rawZstdFrame(const char* src, size_t len, char* dst) {
+        unsigned char* out = (unsigned char*)dst;
+        size_t pos = 0;
+        const unsigned char header[] = {0x28, 0xB5, 0x2F, 0xFD, 0xA0};  //  ,  ,  - 4 
+        memcpy(out, header, sizeof(header));
+        pos += sizeof(header);
+        for (int i = 0; i < 4; i++) out[pos++] = (unsigned char)(len >> (8 * i));
+        size_t done = 0;
+        do {
+            size_t n = len - done > (128 << 10) ? (128 << 10) : len - done;
+            uint32_t blockHeader = (uint32_t)(n << 3) | (done + n == len ? 1 : 0);  //  0 -  
+            for (int i = 0; i < 3; i++) out[pos++] = (unsigned char)(blockHeader >> (8 * i));
+            memcpy(out + pos, src + done, n);
+            pos += n;
+            done += n;
+        } while (done < len);
+        return pos;
+    }
+
+    /**     m_frame
+     * @param emergency -  :     
+     * @return  
+    */
+    size_t compressFrame(bool emergency) {
+        size_t n;
+#ifdef LOG_USE_ZSTD
+        if (m_codec == LogCompression::zstd) {
+            if (emergency) n = rawZstdFrame(m_block.data(), m_used, m_frame.data());
+            else {
+                n = ZSTD_compressCCtx(m_zstd, m_frame.data(), m_frame.size(), m_block.data(), m_used, m_level);
+                if (ZSTD_isError(n)) n = rawZstdFrame(m_block.data(), m_used, m_frame.data());
+            }
+        }
+        else
+#endif
+        {
+            (void)emergency;
+            n = m_lz4.compressFrame(m_block.data(), m_used, m_frame.data());
+        }
+        return n;
+    }
+
+    /**         */
+    void compressBlock() {
+        if (m_used == 0) return;
+        size_t n = compressFrame(false);
+        m_file->write(m_frame.data(), n);
+        m_plainBytes += m_used;
+        m_compressedBytes += n;
+        m_used = 0;
+    }
+
+public:
+    /** @param file -     ( ),  FileSink
+     * @param codec -  (zstd  LOG_USE_ZSTD   lz4)
+     * @param blockSize -   .  : 1  ( LZ4   4 )
+     * @param level -  : zstd 1..19, LZ4 1..6.  : 1
+    */
+    CompressedFileSink(LogSink* file, LogCompression codec, size_t blockSize = 1 << 20, int level = 1)
+        : m_file(file), m_codec(codec), m_blockSize(blockSize), m_level(level), m_used(0), m_lz4(blockSize, level),
+        m_plainBytes(0), m_compressedBytes(0) {
+#ifdef LOG_USE_ZSTD
+        m_zstd = ZSTD_createCCtx();
+        size_t bound = ZSTD_compressBound(m_blockSize);
+#else
+        size_t bound = 0;
+        if (m_codec == LogCompression::zstd) m_codec = LogCompression::lz4;
+#endif
+        if (m_codec == LogCompression::lz4 && m_blockSize > (4 << 20)) m_blockSize = 4 << 20;
+        if (m_blockSize == 0) m_blockSize = 1;
+        m_block.resize(m_blockSize);
+        size_t raw = m_blockSize + m_blockSize / (128 << 10) * 3 + 16;  //  zstd   
+        if (bound < raw) bound = raw;
+        if (bound < Lz4FrameWriter::frameBound(m_blockSize)) bound = Lz4FrameWriter::frameBound(m_blockSize);
+        m_frame.resize(bound);
+    }
+
+    CompressedFileSink(const CompressedFileSink&) = delete;
+    CompressedFileSink& operator=(const CompressedFileSink&) = delete;
+
+    ~CompressedFileSink() {
+        flush();
+        delete m_file;
+#ifdef LOG_USE_ZSTD
+        ZSTD_freeCCtx(m_zstd);
+#endif
+    }
+
+    /**    */
+    LogCompression codec() const {
+        return m_codec;
+    }
+
+    /**       (  ) */
+    unsigned long long plainBytes() const { return m_plainBytes; }
+    unsigned long long compressedBytes() const { return m_compressedBytes; }
+
+    void write(const char* data, size_t len) override {
+        while (len > 0) {
+            size_t n = m_blockSize - m_used;
+            if (n > len) n = len;
+            memcpy(m_block.data() + m_used, data, n);
+            m_used += n;
+            data += n;
+            len -= n;
+            if (m_used == m_blockSize) compressBlock();
+        }
+    }
+
+    void flush() override {
+        compressBlock();
+        m_file->flush();
+    }
+
+    void sync() override {
+        compressBlock();
+        m_file->sync();
+    }
+
+    /**  :    .  -1,  
+     *      ,     .
+    */
+    int emergencyFlush() override {
+        int fd = m_file->emergencyFlush();
+        if (fd < 0 || m_used == 0) return -1;
+        //     :  FileSink     
+        size_t n = compressFrame(true);
+        size_t done = 0;
+        while (done < n) {
+#ifdef _WIN32
+            int w = _write(fd, m_frame.data() + done, (unsigned)(n - done));
+#else
+            ssize_t w = ::write(fd, m_frame.data() + done, n - done);
+            if (w < 0 && errno == EINTR) continue;
+#endif
+            if (w <= 0) break;
+            done += w;
+        }
+        m_used = 0;
+        return -1;
+    }
+};
+
+#endif // LOG_COMPRESS_H
@@ -0,0 +1,166 @@
+#ifndef LOG_CONTEXT_H
+#define LOG_CONTEXT_H
+
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <type_traits>
+using namespace std;
+
+/**   :    "=" ,  -  */
+#ifndef LOG_CONTEXT_SIZE
+#define LOG_CONTEXT_SIZE 256
+#endif
+
+/**    (MDC):  "=",    {ctx}
+ *    ,   .        .
+ * :
+ *   LogContext request("req", requestId);
+ *   LogContext user("user", userName);
+ *   LOGI("order created");          //  "{t} {ctx} -> {m}": "... req=42 user=alice -> order created"
+ *           (  
+ *    ),     -    ,   -  memcpy.
+ *       ,       {ctx}.
+ *      ( ,  ): capture()    
+ * LogContext(snapshot)  wrap()  -.
+ */
+class LogContext {
+public:
+    /**    ( ),       */
+    class Snapshot {
+    public:
+        Snapshot() : m_length(0) {}
+
+        const char* data() const {
+            return m_text;
+        }
+
+        size_t size() const {
+            return m_length;
+        }
+
+    private:
+        friend class LogContext;
+
+        size_t m_length;
+        char m_text[LOG_CONTEXT_SIZE];
+    };
+
+    /** ,    ,     (. wrap) */
+    template <typename F>
+    struct Bound {
+        Snapshot snapshot;
+        F function;
+
+        void operator()() {
+            LogContext restore(snapshot);
+            function();
+        }
+    };
+
+    /**     
+     * @param key - ,  "req"
+     * @param value - 
+    */
+    LogContext(const char* key, const string& value) : m_prev(top()) {
+        push(key, value.data(), value.size());
+    }
+
+    LogContext(const char* key, const char* value) : m_prev(top()) {
+        push(key, value, strlen(value));
+    }
+
+    /**     (int, long, size_t, uint64_t ...):    long long,
+     *  -  unsigned long long,     
+    */
+    template <typename N, typename enable_if<is_integral<N>::value, int>::type = 0>
+    LogContext(const char* key, N value) : m_prev(top()) {
+        char number[24];
+        int length = is_signed<N>::value ? snprintf(number, sizeof(number), "%lld", (long long)value) : 
+            snprintf(number, sizeof(number), "%llu", (unsigned long long)value);
+        push(key, number, length > 0 ? (size_t)length : 0);
+    }
+
+    /**      :      
+     *   (   )
+     * @param snapshot -   capture()
+    */
+    explicit LogContext(const Snapshot& snapshot) : m_prev(top()), m_length(snapshot.m_length) {
+        memcpy(m_text, snapshot.m_text, m_length);
+        top() = this;
+    }
+
+    /**   :  ,     */
+    ~LogContext() {
+        top() = m_prev;
+    }
+
+    LogContext(const LogContext&) = delete;
+    LogContext& operator=(const LogContext&) = delete;
+
+    /**     */
+    static Snapshot capture() {
+        Snapshot snapshot;
+        const LogContext* current = top();
+        if (current) {
+            snapshot.m_length = current->m_length;
+            memcpy(snapshot.m_text, current->m_text, current->m_length);
+        }
+        return snapshot;
+    }
+
+    /**     :   ,    .
+     * : pool.submit(LogContext::wrap([=]() { LOGI("job done"); }));
+     * @param function -   
+    */
+    template <typename F>
+    static Bound<F> wrap(F function) {
+        Bound<F> bound = {capture(), function};
+        return bound;
+    }
+
+    /**        */
+    static void appendTo(string& out) {
+        const LogContext* current = top();
+        if (current) out.append(current->m_text, current->m_length);
+    }
+
+    /** ,      */
+    static bool empty() {
+        return top() == nullptr || top()->m_length == 0;
+    }
+
+private:
+    LogContext* m_prev;
+    size_t m_length;
+    char m_text[LOG_CONTEXT_SIZE];
+
+    /**      */
+    static LogContext*& top() {
+        static thread_local LogContext* current = nullptr;
+        return current;
+    }
+
+    /**  :  , , "=" (    ) */
+    void push(const char* key, const char* value, size_t valueLength) {
+        m_length = 0;
+        if (m_prev) {
+            m_length = m_prev->m_length;
+            memcpy(m_text, m_prev->m_text, m_length);
+            if (m_length > 0) append(" ", 1);
+        }
+        append(key, strlen(key));
+        append("=", 1);
+        append(value, valueLength);
+        top() = this;
+    }
+
+    void append(const char* data, size_t length) {
+        if (length > LOG_CONTEXT_SIZE - m_length) length = LOG_CONTEXT_SIZE - m_length;
+        memcpy(m_text + m_length, data, length);
+        m_length += length;
+    }
+};
+
+#endif // LOG_CONTEXT_H
@@ -0,0 +1,305 @@
+#ifndef LOG_CRASH_H
+#define LOG_CRASH_H
+
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <cstdlib>
+#include <exception>
+#include <cerrno>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define LOG_CRASH_BACKTRACE 1
+#endif
+using namespace std;
+
+/**       .
+ *       async-signal-safe  (write(2)).
+ */
+class CrashWriter {
+private:
+    char m_data[4096];
+    size_t m_len;
+    long m_tzOffset;
+
+public:
+    /** @param tzOffset -     UTC   ( ) */
+    explicit CrashWriter(long tzOffset) : m_len(0), m_tzOffset(tzOffset) {}
+
+    void append(const char* str) {
+        append(str, strlen(str));
+    }
+
+    void append(const char* data, size_t len) {
+        if (len > sizeof(m_data) - m_len) len = sizeof(m_data) - m_len;
+        memcpy(m_data + m_len, data, len);
+        m_len += len;
+    }
+
+    /**   ( snprintf,    async-signal-safe) */
+    void appendNumber(long long value, int width = 0) {
+        char buf[24];
+        int n = 0;
+        bool negative = value < 0;
+        unsigned long long v = negative ? -(unsigned long long)value : (unsigned long long)value;
+        do {
+            buf[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v > 0);
+        while (n < width) buf[n++] = '0';
+        if (negative) buf[n++] = '-';
+        while (n > 0) append(&buf[--n], 1);
+    }
+
+    /**       "yyyy-mm-dd hh:mm:ss"  localtime()
+     * @param seconds -       (UTC)
+    */
+    void appendDatetime(long long seconds) {
+        seconds += m_tzOffset;
+        long long days = seconds / 86400;
+        long long rest = seconds % 86400;
+        if (rest < 0) { rest += 86400; days--; }
+        //       ( H. Hinnant)
+        days += 719468;
+        long long era = (days >= 0 ? days : days - 146096) / 146097;
+        long long doe = days - era * 146097;
+        long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        long long mp = (5 * doy + 2) / 153;
+        long long day = doy - (153 * mp + 2) / 5 + 1;
+        long long month = mp < 10 ? mp + 3 : mp - 9;
+        long long year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+        appendNumber(year, 4); append("-");
+        appendNumber(month, 2); append("-");
+        appendNumber(day, 2); append(" ");
+        appendNumber(rest / 3600, 2); append(":");
+        appendNumber(rest / 60 % 60, 2); append(":");
+        appendNumber(rest % 60, 2);
+    }
+
+    /**         */
+    void flushTo(int fd) {
+        size_t done = 0;
+        while (done < m_len) {
+#ifdef _WIN32
+            int n = _write(fd, m_data + done, (unsigned)(m_len - done));
+#else
+            ssize_t n = ::write(fd, m_data + done, m_len - done);
+            if (n < 0 && errno == EINTR) continue;
+#endif
+            if (n <= 0) break;
+            done += n;
+        }
+        m_len = 0;
+    }
+};
+
+/**  :  SIGSEGV/SIGABRT/SIGBUS/SIGFPE/SIGILL  std::terminate
+ *     (   ),
+ *         .
+ *    ,     async-signal-safe .
+ */
+class LogCrashHandler {
+public:
+    /**   : ctx - , crash -  , frames -   */
+    typedef void (*DrainFn)(void* ctx, const char* crash, void** frames, int nframes);
+
+    /**     */
+    static const int max_frames = 64;
+
+    /**   (       )
+     * @param crashFile -   ,      .
+     *  : "" (stderr)
+     *         -rdynamic (Linux).
+     * @return true,   
+    */
+    static bool install(const char* crashFile = "") {
+        State& st = state();
+        if (crashFile && crashFile[0] != '\0') {
+#ifdef _WIN32
+            int fd = _open(crashFile, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+#else
+            int fd = ::open(crashFile, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+            if (fd >= 0) st.fd = fd;
+        }
+        if (st.installed) return true;
+
+        //     : localtime()    
+        time_t now = time(0);
+        tm local = *localtime(&now);
+        tm utc = *gmtime(&now);
+        utc.tm_isdst = local.tm_isdst;
+        st.tzOffset = (long)difftime(now, mktime(&utc));
+
+#ifdef LOG_CRASH_BACKTRACE
+        //   backtrace()  libgcc -   ,    
+        void* warmup[2];
+        backtrace(warmup, 2);
+#endif
+        static const int signals[] = {SIGSEGV, SIGABRT, SIGFPE, SIGILL
+#ifdef SIGBUS
+            , SIGBUS
+#endif
+        };
+#ifdef _WIN32
+        for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) signal(signals[i], onSignal);
+#else
+        //  ,        
+        static char altstack[64 * 1024];
+        stack_t ss;
+        memset(&ss, 0, sizeof(ss));
+        ss.ss_sp = altstack;
+        ss.ss_size = sizeof(altstack);
+        sigaltstack(&ss, 0);
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = onSignal;
+        sa.sa_flags = SA_ONSTACK | SA_RESETHAND;
+        sigemptyset(&sa.sa_mask);
+        for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) sigaction(signals[i], &sa, 0);
+#endif
+        st.previousTerminate = set_terminate(onTerminate);
+        st.installed = true;
+        return true;
+    }
+
+    /**    
+     * @return false,    
+    */
+    static bool addDrain(DrainFn fn, void* ctx) {
+        State& st = state();
+        for (int i = 0; i < max_drains; i++) {
+            if (st.drains[i].fn == nullptr) {
+                st.drains[i].ctx = ctx;
+                st.drains[i].fn = fn;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**       ctx */
+    static void removeDrain(void* ctx) {
+        State& st = state();
+        for (int i = 0; i < max_drains; i++) {
+            if (st.drains[i].ctx == ctx) st.drains[i].fn = nullptr;
+        }
+    }
+
+    /**       (stderr  crashFile) */
+    static int fallbackFd() {
+        return state().fd;
+    }
+
+    /**     (nanosleep - async-signal-safe)
+     * @param ms -   
+    */
+    static void pause(int ms) {
+#ifdef _WIN32
+        Sleep(ms);
+#else
+        timespec ts;
+        ts.tv_sec = ms / 1000;
+        ts.tv_nsec = (ms % 1000) * 1000000L;
+        nanosleep(&ts, 0);
+#endif
+    }
+
+    /**     UTC,    */
+    static long tzOffset() {
+        return state().tzOffset;
+    }
+
+private:
+    static const int max_drains = 8;
+
+    struct Drain {
+        DrainFn fn;
+        void* ctx;
+    };
+
+    struct State {
+        bool installed;
+        int fd;
+        long tzOffset;
+        volatile sig_atomic_t draining;
+        terminate_handler previousTerminate;
+        Drain drains[max_drains];
+    };
+
+    /**   (   -        ) */
+    static State& state() {
+        static State st = {false, 2, 0, 0, nullptr, {}};
+        return st;
+    }
+
+    /**      */
+    static void drainAll(const char* crash) {
+        State& st = state();
+        if (st.draining) return;
+        st.draining = 1;
+        void* frames[max_frames];
+        int nframes = 0;
+#ifdef LOG_CRASH_BACKTRACE
+        nframes = backtrace(frames, max_frames);
+#endif
+        bool any = false;
+        for (int i = 0; i < max_drains; i++) {
+            if (st.drains[i].fn) {
+                st.drains[i].fn(st.drains[i].ctx, crash, frames, nframes);
+                any = true;
+            }
+        }
+        if (!any) {
+            //  :         
+            CrashWriter w(st.tzOffset);
+            w.appendDatetime((long long)time(0));
+            w.append(" | ERROR -> ");
+            w.append(crash);
+            w.append("\n");
+            w.flushTo(st.fd);
+#ifdef LOG_CRASH_BACKTRACE
+            backtrace_symbols_fd(frames, nframes, st.fd);
+#endif
+        }
+    }
+
+    static const char* signalName(int sig) {
+        switch (sig) {
+        case SIGSEGV: return "crash: signal SIGSEGV";
+        case SIGABRT: return "crash: signal SIGABRT";
+        case SIGFPE: return "crash: signal SIGFPE";
+        case SIGILL: return "crash: signal SIGILL";
+#ifdef SIGBUS
+        case SIGBUS: return "crash: signal SIGBUS";
+#endif
+        default: return "crash: signal";
+        }
+    }
+
+    static void onSignal(int sig) {
+        drainAll(signalName(sig));
+        //    (SA_RESETHAND) -     
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+
+    static void onTerminate() {
+        drainAll("crash: std::terminate");
+        terminate_handler previous = state().previousTerminate;
+        if (previous) previous();
+        abort();
+    }
+};
+
+#endif // LOG_CRASH_H
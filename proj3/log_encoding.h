@@ -0,0 +1,182 @@
+#ifndef LOG_ENCODING_H
+#define LOG_ENCODING_H
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+using namespace std;
+
+/**    */
+enum class LogEncoding {none, cp1251, utf8};
+
+/**    Windows-1251 <-> UTF-8  .
+ * ASCII-   8   ;    ASCII   ,
+ *        .
+ */
+class LogTranscoder {
+public:
+    /**    */
+    LogTranscoder() : m_from(LogEncoding::none), m_to(LogEncoding::none) {}
+
+    /** @param from -   
+     * @param to -   
+    */
+    LogTranscoder(LogEncoding from, LogEncoding to) : m_from(from), m_to(to) {}
+
+    LogEncoding from() const {
+        return m_from;
+    }
+
+    LogEncoding to() const {
+        return m_to;
+    }
+
+    /** ,     */
+    bool active() const {
+        return m_from != m_to && m_from != LogEncoding::none && m_to != LogEncoding::none;
+    }
+
+    /**  
+     * @param data -  
+     * @param len -   
+     * @param outLen -  
+     * @return   :  ,   ,   
+     * (   )
+    */
+    const char* convert(const char* data, size_t len, size_t& outLen) {
+        outLen = len;
+        if (!active()) return data;
+        size_t ascii = asciiPrefix(data, len);
+        if (ascii == len) return data;
+        m_buffer.assign(data, ascii);
+        if (m_from == LogEncoding::cp1251) toUtf8(data + ascii, len - ascii);
+        else toCp1251(data + ascii, len - ascii);
+        outLen = m_buffer.size();
+        return m_buffer.data();
+    }
+
+    /**     ASCII- (   8 ) */
+    static size_t asciiPrefix(const char* data, size_t len) {
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            if (word & 0x8080808080808080ULL) break;
+        }
+        while (i < len && (unsigned char)data[i] < 0x80) i++;
+        return i;
+    }
+
+private:
+    LogEncoding m_from;
+    LogEncoding m_to;
+    string m_buffer;
+
+    /**  Unicode   0x80..0xBF Windows-1251 (0xC0..0xFF -   U+0410) */
+    static const uint16_t* upperTable() {
+        static const uint16_t table[64] = {
+            0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+            0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+            0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+            0xFFFD, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+            0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+            0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+            0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+            0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457
+        };
+        return table;
+    }
+
+    static unsigned codePoint(unsigned char c) {
+        return c >= 0xC0 ? 0x0410 + (c - 0xC0) : upperTable()[c - 0x80];
+    }
+
+    /**   UTF-8   0x80..0xFF:    3  */
+    struct Utf8Char {
+        unsigned char length;
+        char bytes[3];
+    };
+
+    struct Utf8Table {
+        Utf8Char items[128];
+
+        Utf8Table() {
+            for (unsigned c = 0x80; c < 0x100; c++) {
+                unsigned cp = codePoint((unsigned char)c);
+                Utf8Char& u = items[c - 0x80];
+                if (cp < 0x800) {
+                    u.length = 2;
+                    u.bytes[0] = (char)(0xC0 | (cp >> 6));
+                    u.bytes[1] = (char)(0x80 | (cp & 0x3F));
+                }
+                else {
+                    u.length = 3;
+                    u.bytes[0] = (char)(0xE0 | (cp >> 12));
+                    u.bytes[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    u.bytes[2] = (char)(0x80 | (cp & 0x3F));
+                }
+            }
+        }
+    };
+
+    static const Utf8Char* utf8Table() {
+        static const Utf8Table table;
+        return table.items;
+    }
+
+    /**  Windows-1251   Unicode ('?'     ) */
+    static char cp1251Of(unsigned cp) {
+        if (cp < 0x80) return (char)cp;
+        if (cp >= 0x0410 && cp <= 0x044F) return (char)(0xC0 + (cp - 0x0410));
+        const uint16_t* table = upperTable();
+        for (int i = 0; i < 64; i++) {
+            if (table[i] == cp && cp != 0xFFFD) return (char)(0x80 + i);
+        }
+        return '?';
+    }
+
+    void toUtf8(const char* data, size_t len) {
+        const Utf8Char* table = utf8Table();
+        //  Windows-1251    3  UTF-8
+        m_buffer.reserve(m_buffer.size() + len * 2);
+        size_t i = 0;
+        while (i < len) {
+            unsigned char c = (unsigned char)data[i];
+            if (c < 0x80) {
+                size_t run = asciiPrefix(data + i, len - i);
+                m_buffer.append(data + i, run);
+                i += run;
+                continue;
+            }
+            const Utf8Char& u = table[c - 0x80];
+            m_buffer.append(u.bytes, u.length);
+            i++;
+        }
+    }
+
+    void toCp1251(const char* data, size_t len) {
+        m_buffer.reserve(m_buffer.size() + len);
+        size_t i = 0;
+        while (i < len) {
+            unsigned char c = (unsigned char)data[i];
+            if (c < 0x80) {
+                size_t run = asciiPrefix(data + i, len - i);
+                m_buffer.append(data + i, run);
+                i += run;
+                continue;
+            }
+            //   UTF-8;    '?'
+            size_t need = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+            unsigned cp = need == 3 ? (c & 0x07) : need == 2 ? (c & 0x0F) : (c & 0x1F);
+            bool valid = need > 0;
+            for (size_t k = 1; valid && k <= need; k++) {
+                if (i + k >= len || ((unsigned char)data[i + k] & 0xC0) != 0x80) valid = false;
+                else cp = (cp << 6) | ((unsigned char)data[i + k] & 0x3F);
+            }
+            m_buffer += valid ? cp1251Of(cp) : '?';
+            i += valid ? need + 1 : 1;
+        }
+    }
+};
+
+#endif // LOG_ENCODING_H
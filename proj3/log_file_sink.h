@@ -0,0 +1,572 @@
+#ifndef LOG_FILE_SINK_H
+#define LOG_FILE_SINK_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "log_sink.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+using namespace std;
+
+#ifdef __linux__
+/**    io_uring    ( liburing).
+ *    :  ,  -.
+ */
+class IoUring {
+private:
+    int m_fd;
+    unsigned m_entries;
+    unsigned m_tail;        //   SQ (   )
+    void* m_sqPtr;
+    void* m_cqPtr;
+    size_t m_sqSize;
+    size_t m_cqSize;
+    io_uring_sqe* m_sqes;
+    size_t m_sqesSize;
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    io_uring_cqe* m_cqes;
+
+public:
+    IoUring() : m_fd(-1), m_entries(0), m_tail(0), m_sqPtr(0), m_cqPtr(0), m_sqSize(0), m_cqSize(0), m_sqes(0), m_sqesSize(0) {}
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() {
+        release();
+    }
+
+    /**  
+     * @param entries -     
+     * @return true,    io_uring   
+    */
+    bool init(unsigned entries) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        m_fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+        if (m_fd < 0) return false;
+
+        m_sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cqSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) m_sqSize = m_cqSize = (m_sqSize > m_cqSize ? m_sqSize : m_cqSize);
+
+        m_sqPtr = mmap(0, m_sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        if (m_sqPtr == MAP_FAILED) { m_sqPtr = 0; release(); return false; }
+        if (single) m_cqPtr = m_sqPtr;
+        else {
+            m_cqPtr = mmap(0, m_cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+            if (m_cqPtr == MAP_FAILED) { m_cqPtr = 0; release(); return false; }
+        }
+        m_sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(0, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) { release(); return false; }
+        m_sqes = (io_uring_sqe*)sqes;
+
+        char* sq = (char*)m_sqPtr;
+        m_sqHead = (unsigned*)(sq + p.sq_off.head);
+        m_sqTail = (unsigned*)(sq + p.sq_off.tail);
+        m_sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+        m_sqArray = (unsigned*)(sq + p.sq_off.array);
+        char* cq = (char*)m_cqPtr;
+        m_cqHead = (unsigned*)(cq + p.cq_off.head);
+        m_cqTail = (unsigned*)(cq + p.cq_off.tail);
+        m_cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+        m_cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+        m_entries = p.sq_entries;
+        m_tail = *m_sqTail;
+        return true;
+    }
+
+    /**   */
+    void release() {
+        if (m_sqes) munmap(m_sqes, m_sqesSize);
+        if (m_cqPtr && m_cqPtr != m_sqPtr) munmap(m_cqPtr, m_cqSize);
+        if (m_sqPtr) munmap(m_sqPtr, m_sqSize);
+        if (m_fd >= 0) ::close(m_fd);
+        m_sqes = 0; m_cqPtr = 0; m_sqPtr = 0; m_fd = -1;
+    }
+
+    /**      
+     * @return      nullptr,   
+    */
+    io_uring_sqe* getSqe() {
+        unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        if (m_tail - head >= m_entries) return nullptr;
+        unsigned idx = m_tail & *m_sqMask;
+        m_sqArray[idx] = idx;
+        m_tail++;
+        memset(&m_sqes[idx], 0, sizeof(io_uring_sqe));
+        return &m_sqes[idx];
+    }
+
+    /**    
+     * @param waitNr -    (0 -  )
+     * @return  io_uring_enter
+    */
+    int submit(unsigned waitNr) {
+        unsigned toSubmit = m_tail - *m_sqTail;
+        __atomic_store_n(m_sqTail, m_tail, __ATOMIC_RELEASE);
+        int ret;
+        do {
+            ret = (int)syscall(__NR_io_uring_enter, m_fd, toSubmit, waitNr, waitNr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        } while (ret < 0 && errno == EINTR);
+        return ret;
+    }
+
+    /**   ,   
+     * @param userData -    
+     * @param res -   (  -errno)
+     * @return true,    
+    */
+    bool popCqe(unsigned long long& userData, int& res) {
+        unsigned head = *m_cqHead;
+        if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) return false;
+        io_uring_cqe* cqe = &m_cqes[head & *m_cqMask];
+        userData = cqe->user_data;
+        res = cqe->res;
+        __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+#endif // __linux__
+
+/**      .
+ *       ;     ,
+ *          ( ).
+ *  Linux    io_uring    " ",
+ *    -   pwritev.  Windows -   _write.
+ */
+class FileSink : public LogSink {
+private:
+    /**   */
+    enum BufferState {buffer_free, buffer_ready, buffer_inflight};
+
+    struct Buffer {
+        vector<char> data;
+        size_t used;
+        long long offset;
+        BufferState state;
+    };
+
+    /**    fdatasync  io_uring */
+    static const unsigned long long sync_tag = ~0ULL;
+
+    int m_fd;
+    long long m_offset;
+    bool m_datasync;
+    size_t m_bufferSize;
+    vector<Buffer> m_buffers;
+    int m_current;
+    vector<int> m_ready;
+    unsigned m_inflight;
+    unsigned long long m_errors;
+#ifdef __linux__
+    IoUring m_ring;
+    bool m_useUring;
+#endif
+
+    /**           */
+    bool writeAll(const char* data, size_t len, long long offset) {
+        while (len > 0) {
+#ifdef _WIN32
+            if (_lseeki64(m_fd, offset, SEEK_SET) < 0) return false;
+            int n = _write(m_fd, data, (unsigned)len);
+#else
+            ssize_t n = pwrite(m_fd, data, len, (off_t)offset);
+#endif
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            len -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    /**       (pwritev,     - writeAll) */
+    bool writeVector(const LogSlice* parts, size_t count, long long offset) {
+        size_t done = 0;
+#ifndef _WIN32
+        vector<iovec> iov(count);
+        for (size_t i = 0; i < count; i++) {
+            iov[i].iov_base = (void*)parts[i].data;
+            iov[i].iov_len = parts[i].len;
+        }
+        ssize_t n;
+        do {
+            n = pwritev(m_fd, iov.data(), (int)iov.size(), (off_t)offset);
+        } while (n < 0 && errno == EINTR);
+        if (n > 0) done = (size_t)n;
+#endif
+        bool ok = true;
+        for (size_t i = 0; i < count; i++) {
+            if (done >= parts[i].len) done -= parts[i].len;
+            else {
+                if (!writeAll(parts[i].data + done, parts[i].len - done, offset + done)) ok = false;
+                done = 0;
+            }
+            offset += parts[i].len;
+        }
+        return ok;
+    }
+
+    /**       ""   pwritev */
+    void writeReady() {
+        if (m_ready.empty()) return;
+        size_t done = 0;
+#ifndef _WIN32
+        vector<iovec> iov(m_ready.size());
+        for (size_t i = 0; i < m_ready.size(); i++) {
+            iov[i].iov_base = m_buffers[m_ready[i]].data.data();
+            iov[i].iov_len = m_buffers[m_ready[i]].used;
+        }
+        ssize_t n;
+        do {
+            n = pwritev(m_fd, iov.data(), (int)iov.size(), (off_t)m_buffers[m_ready[0]].offset);
+        } while (n < 0 && errno == EINTR);
+        if (n > 0) done = (size_t)n;
+#endif
+        //  ,  pwritev   
+        for (size_t i = 0; i < m_ready.size(); i++) {
+            Buffer& b = m_buffers[m_ready[i]];
+            if (done >= b.used) done -= b.used;
+            else {
+                if (!writeAll(b.data.data() + done, b.used - done, b.offset + done)) m_errors++;
+                done = 0;
+            }
+            b.state = buffer_free;
+        }
+        m_ready.clear();
+    }
+
+#ifdef __linux__
+    /**   io_uring
+     * @param wait -     
+    */
+    void reap(bool wait) {
+        if (wait) m_ring.submit(1);
+        unsigned long long tag;
+        int res;
+        while (m_ring.popCqe(tag, res)) {
+            m_inflight--;
+            if (tag == sync_tag) {
+                if (res < 0) m_errors++;
+                continue;
+            }
+            Buffer& b = m_buffers[(size_t)tag];
+            //     -  
+            size_t done = res > 0 ? (size_t)res : 0;
+            if (done < b.used && !writeAll(b.data.data() + done, b.used - done, b.offset + done)) m_errors++;
+            b.state = buffer_free;
+        }
+    }
+
+    /**    io_uring;      */
+    io_uring_sqe* acquireSqe() {
+        io_uring_sqe* sqe;
+        while ((sqe = m_ring.getSqe()) == nullptr) reap(true);
+        return sqe;
+    }
+#endif
+
+    /**      */
+    void submit(int index) {
+        Buffer& b = m_buffers[index];
+        b.offset = m_offset;
+        m_offset += b.used;
+#ifdef __linux__
+        if (m_useUring) {
+            io_uring_sqe* sqe = acquireSqe();
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = m_fd;
+            sqe->addr = (unsigned long long)(uintptr_t)b.data.data();
+            sqe->len = (unsigned)b.used;
+            sqe->off = (unsigned long long)b.offset;
+            sqe->user_data = (unsigned long long)index;
+            b.state = buffer_inflight;
+            m_inflight++;
+            m_ring.submit(0);
+            return;
+        }
+#endif
+        b.state = buffer_ready;
+        m_ready.push_back(index);
+    }
+
+    /**    ;     -    */
+    void nextBuffer() {
+        int next = (m_current + 1) % (int)m_buffers.size();
+        while (m_buffers[next].state != buffer_free) {
+#ifdef __linux__
+            if (m_useUring) { reap(true); continue; }
+#endif
+            writeReady();
+        }
+        m_current = next;
+        m_buffers[next].used = 0;
+    }
+
+    /**      */
+    void drain() {
+#ifdef __linux__
+        while (m_inflight > 0) reap(true);
+#endif
+        writeReady();
+    }
+
+public:
+    /**    
+     * @param filename -  
+     * @param bufferSize -     .  : 1 
+     * @param buffers -   (  2).  : 4
+     * @param datasync -  fdatasync   flush().  : false
+     * @param useUring -  io_uring,   .  : true
+    */
+    FileSink(const string& filename, size_t bufferSize = 1 << 20, int buffers = 4, bool datasync = false, bool useUring = true)
+        : m_fd(-1), m_offset(0), m_datasync(datasync), m_bufferSize(bufferSize ? bufferSize : 1), m_current(0), m_inflight(0), m_errors(0) {
+#ifdef _WIN32
+        m_fd = _open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (m_fd >= 0) m_offset = _lseeki64(m_fd, 0, SEEK_END);
+#else
+        m_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        if (m_fd >= 0) m_offset = lseek(m_fd, 0, SEEK_END);
+#endif
+        if (buffers < 2) buffers = 2;
+        m_buffers.resize(buffers);
+        //           (. write)
+        for (size_t i = 0; i < m_buffers.size(); i++) {
+            m_buffers[i].used = 0;
+            m_buffers[i].offset = 0;
+            m_buffers[i].state = buffer_free;
+        }
+#ifdef __linux__
+        //  :   +  fdatasync
+        m_useUring = useUring && m_fd >= 0 && m_ring.init((unsigned)buffers + 1);
+#else
+        (void)useUring;
+#endif
+    }
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    ~FileSink() {
+        if (m_fd < 0) return;
+        flush();
+#ifdef _WIN32
+        _close(m_fd);
+#else
+        ::close(m_fd);
+#endif
+    }
+
+    /** ,     */
+    bool isOpen() const {
+        return m_fd >= 0;
+    }
+
+    /** ,   io_uring */
+    bool usesUring() const {
+#ifdef __linux__
+        return m_useUring;
+#else
+        return false;
+#endif
+    }
+
+    /**     ,      */
+    long long size() const {
+        return m_offset + (long long)m_buffers[m_current].used;
+    }
+
+    /**       */
+    unsigned long long errors() const {
+        return m_errors;
+    }
+
+    void write(const char* data, size_t len) override {
+        if (m_fd < 0) return;
+        while (len > 0) {
+            Buffer& b = m_buffers[m_current];
+            if (b.data.empty()) b.data.resize(m_bufferSize);
+            size_t n = m_bufferSize - b.used;
+            if (n > len) n = len;
+            memcpy(b.data.data() + b.used, data, n);
+            b.used += n;
+            data += n;
+            len -= n;
+            if (b.used == m_bufferSize) {
+                submit(m_current);
+                nextBuffer();
+            }
+        }
+    }
+
+    /**   :         -  
+     *   ,       pwritev    
+    */
+    void writeParts(const LogSlice* parts, size_t count) override {
+        if (m_fd < 0) return;
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++) total += parts[i].len;
+        if (total < m_bufferSize / 4) {
+            LogSink::writeParts(parts, count);
+            return;
+        }
+        if (m_buffers[m_current].used > 0) {
+            submit(m_current);
+            nextBuffer();
+        }
+        long long offset = m_offset;
+        m_offset += total;
+        if (!writeVector(parts, count, offset)) m_errors++;
+    }
+
+    void flush() override {
+        if (m_fd < 0) return;
+        if (m_buffers[m_current].used > 0) {
+            submit(m_current);
+            nextBuffer();
+        }
+        drain();
+        if (m_datasync) syncFile();
+    }
+
+    void sync() override {
+        if (m_fd < 0) return;
+        bool datasync = m_datasync;
+        m_datasync = false;
+        flush();
+        m_datasync = datasync;
+        syncFile();
+    }
+
+    /**  : ,    (  io_uring),  pwrite
+     *   ,   .     .
+    */
+    int emergencyFlush() override {
+        if (m_fd < 0) return -1;
+        //    pwrite     ;   m_offset ,
+        //         write(2)
+#ifdef _WIN32
+        long long position = _lseeki64(m_fd, 0, SEEK_CUR);
+#else
+        long long position = lseek(m_fd, 0, SEEK_CUR);
+#endif
+        if (position > m_offset) m_offset = position;
+        for (size_t i = 0; i < m_buffers.size(); i++) {
+            Buffer& b = m_buffers[i];
+            if ((int)i == m_current || b.state == buffer_free) continue;
+            writeAll(b.data.data(), b.used, b.offset);
+            b.state = buffer_free;
+        }
+        Buffer& cur = m_buffers[m_current];
+        if (cur.used > 0) {
+            writeAll(cur.data.data(), cur.used, m_offset);
+            m_offset += cur.used;
+            cur.used = 0;
+        }
+#ifdef _WIN32
+        _lseeki64(m_fd, m_offset, SEEK_SET);
+#else
+        lseek(m_fd, (off_t)m_offset, SEEK_SET);
+#endif
+        return m_fd;
+    }
+
+    /**      fdatasync (    ofstream,
+     *        , . Logs)
+     * @param filename -  
+     * @return   -1
+    */
+    static int openForSync(const string& filename) {
+#ifdef _WIN32
+        return _open(filename.c_str(), _O_WRONLY | _O_BINARY);
+#else
+        return ::open(filename.c_str(), O_WRONLY | O_CLOEXEC);
+#endif
+    }
+
+    /** fdatasync ,  openForSync
+     * @return true,   
+    */
+    static bool syncDescriptor(int fd) {
+#ifdef _WIN32
+        return _commit(fd) == 0;
+#elif defined(__linux__)
+        return fdatasync(fd) == 0;
+#else
+        return fsync(fd) == 0;
+#endif
+    }
+
+    static void closeDescriptor(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+
+    /** ,           (     ).
+     *  Windows    ,   
+    */
+    static bool sameFile(int fd, const string& filename) {
+#ifdef _WIN32
+        (void)fd;
+        (void)filename;
+        return true;
+#else
+        struct stat opened, named;
+        return fstat(fd, &opened) == 0 && stat(filename.c_str(), &named) == 0 && 
+            opened.st_dev == named.st_dev && opened.st_ino == named.st_ino;
+#endif
+    }
+
+private:
+    /** fdatasync  ( io_uring,   ) */
+    void syncFile() {
+#ifdef __linux__
+        if (m_useUring) {
+            io_uring_sqe* sqe = acquireSqe();
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = m_fd;
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+            sqe->user_data = sync_tag;
+            m_inflight++;
+            drain();
+            return;
+        }
+        if (fdatasync(m_fd) != 0) m_errors++;
+#elif defined(_WIN32)
+        if (_commit(m_fd) != 0) m_errors++;
+#else
+        if (fsync(m_fd) != 0) m_errors++;
+#endif
+    }
+};
+
+#endif // LOG_FILE_SINK_H
@@ -0,0 +1,347 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+/**   constexpr:          */
+inline bool unknown_token_in_log_format() {
+    return false;
+}
+
+/**    :    .
+ *     ( setFormat),     .
+ * : {t} -   , {L} - , {m} - , {S} - -, {l} - ,
+ * {ctx} -    (. LogContext).
+ *  ,   ,  LOG_FORMAT("...") / LOGS_SET_FORMAT("..."):
+ *   ( {x})    -  .
+ *     (  )   ,   
+ * ,     (Compiled):        .
+ * ,     ,       .
+ */
+class LogFormat {
+public:
+    /**    */
+    enum Kind {literal, time_token, level_token, message_token, source_token, line_token, context_token, end_of_format};
+
+    /**  :   -       */
+    struct Segment {
+        Kind kind;
+        size_t offset;
+        size_t length;
+    };
+
+    /**  :    (  ) */
+    struct Text {
+        const char* data;
+        size_t size;
+    };
+
+    /**    ,    ( literal  ) */
+    struct Fields {
+        Text token[end_of_format];
+    };
+
+    /**     */
+    static Text text(const string& value) {
+        Text result = {value.data(), value.size()};
+        return result;
+    }
+
+    /**       */
+    typedef void (*Render)(const LogFormat& format, const Fields& values, string& out, size_t* messageAt);
+
+    /**      (. LOG_FORMAT) */
+    template <bool Valid>
+    struct Checked {};
+
+    /**  ,  LOG_FORMAT    */
+    static const size_t compiled_steps = 16;
+
+    /**  ,    (. LOG_FORMAT) */
+    template <Kind K, size_t Offset, size_t Length>
+    struct Step {
+        static const Kind kind = K;
+        static const size_t offset = Offset;
+        static const size_t length = Length;
+    };
+
+    /**   ,   :   -     .
+     *   -   (    )
+    */
+    template <class... Steps>
+    struct Plan {
+        static const size_t literal_length = 0;
+
+        static size_t valueLength(const Fields&) {
+            return 0;
+        }
+
+        static void append(const char*, const Fields&, string&, size_t*) {}
+    };
+
+    template <size_t Offset, size_t Length, class... Rest>
+    struct Plan<Step<literal, Offset, Length>, Rest...> {
+        static const size_t literal_length = Length + Plan<Rest...>::literal_length;
+
+        static size_t valueLength(const Fields& values) {
+            return Plan<Rest...>::valueLength(values);
+        }
+
+        static void append(const char* source, const Fields& values, string& out, size_t* messageAt) {
+            out.append(source + Offset, Length);
+            Plan<Rest...>::append(source, values, out, messageAt);
+        }
+    };
+
+    template <Kind K, size_t Offset, size_t Length, class... Rest>
+    struct Plan<Step<K, Offset, Length>, Rest...> {
+        static const size_t literal_length = Plan<Rest...>::literal_length;
+
+        static size_t valueLength(const Fields& values) {
+            return tokenSize(K, values) + Plan<Rest...>::valueLength(values);
+        }
+
+        static void append(const char* source, const Fields& values, string& out, size_t* messageAt) {
+            appendToken(K, values, out, messageAt);
+            Plan<Rest...>::append(source, values, out, messageAt);
+        }
+    };
+
+    template <size_t Offset, size_t Length, class... Rest>
+    struct Plan<Step<end_of_format, Offset, Length>, Rest...> : Plan<> {};
+
+    /** ,   :     ,    */
+    template <class... Steps>
+    struct Compiled {
+        static constexpr Segment table[sizeof...(Steps)] = {{Steps::kind, Steps::offset, Steps::length}...};
+
+        static void render(const LogFormat& format, const Fields& values, string& out, size_t* messageAt) {
+            out.reserve(out.size() + Plan<Steps...>::literal_length + Plan<Steps...>::valueLength(values));
+            Plan<Steps...>::append(format.source().data(), values, out, messageAt);
+        }
+    };
+
+    /**    */
+    static constexpr bool isToken(char c) {
+        return c == 't' || c == 'L' || c == 'm' || c == 'S' || c == 'l';
+    }
+
+    /**     : 3  {t} {L} {m} {S} {l}, 5  {ctx}, 0 -   */
+    static constexpr size_t tokenLength(const char* f) {
+        return (f[0] == '{' && isToken(f[1]) && f[2] == '}') ? 3
+            : (f[0] == '{' && f[1] == 'c' && f[2] == 't' && f[3] == 'x' && f[4] == '}') ? 5
+            : 0;
+    }
+
+    /**  :  '{'      {t} {L} {m} {S} {l} {ctx} */
+    static constexpr bool isValid(const char* f) {
+        return *f == '\0' ? true
+            : *f == '{' ? (tokenLength(f) != 0 && isValid(f + tokenLength(f)))
+            : isValid(f + 1);
+    }
+
+    /**    LOG_FORMAT:        */
+    static constexpr bool check(const char* f) {
+        return isValid(f) ? true : unknown_token_in_log_format();
+    }
+
+    /**  ,   f (end_of_format -  ) */
+    static constexpr Kind kindOf(const char* f) {
+        return *f == '\0' ? end_of_format
+            : tokenLength(f) == 0 ? literal
+            : f[1] == 'c' ? context_token
+            : f[1] == 't' ? time_token
+            : f[1] == 'L' ? level_token
+            : f[1] == 'm' ? message_token
+            : f[1] == 'S' ? source_token
+            : line_token;
+    }
+
+    /**     p:      */
+    static constexpr size_t literalEnd(const char* f, size_t p) {
+        return (f[p] == '\0' || tokenLength(f + p) != 0) ? p : literalEnd(f, p + 1);
+    }
+
+    /**  ,    p (  -  ) */
+    static constexpr size_t segmentLength(const char* f, size_t p) {
+        return tokenLength(f + p) != 0 ? tokenLength(f + p) : literalEnd(f, p) - p;
+    }
+
+    /**    i (     -  ) */
+    static constexpr size_t offsetAt(const char* f, size_t i, size_t p = 0) {
+        return (f[p] == '\0' || i == 0) ? p : offsetAt(f, i - 1, p + segmentLength(f, p));
+    }
+
+    /**    i (end_of_format   ) */
+    static constexpr Kind kindAt(const char* f, size_t i) {
+        return kindOf(f + offsetAt(f, i));
+    }
+
+    /**    i */
+    static constexpr size_t lengthAt(const char* f, size_t i) {
+        return segmentLength(f, offsetAt(f, i));
+    }
+
+    /**   (   ) */
+    LogFormat() : m_literalLength(0), m_tokens(0), m_render(&renderParsed) {}
+
+    /**     :       
+     * @param format - ,  "{t} | {L} -> {m}"
+    */
+    explicit LogFormat(const string& format) : m_source(format), m_literalLength(0), m_tokens(0), m_render(&renderParsed) {
+        parse();
+    }
+
+    /** ,    (  LOG_FORMAT):    .
+     *    LOG_FORMAT (compiled_steps )       
+     * @param format -   
+    */
+    template <class... Steps>
+    LogFormat(const char* format, Checked<true>, Compiled<Steps...>)
+        : m_source(format), m_literalLength(0), m_tokens(0), m_render(&Compiled<Steps...>::render) {
+        size_t covered = 0;
+        for (size_t i = 0; i < sizeof...(Steps) && Compiled<Steps...>::table[i].kind != end_of_format; i++) {
+            addSegment(Compiled<Steps...>::table[i]);
+            covered = Compiled<Steps...>::table[i].offset + Compiled<Steps...>::table[i].length;
+        }
+        if (covered != m_source.size()) {
+            m_segments.clear();
+            m_literalLength = 0;
+            m_tokens = 0;
+            m_render = &renderParsed;
+            parse();
+        }
+    }
+
+    /**   */
+    const string& source() const {
+        return m_source;
+    }
+
+    /** ,    */
+    bool empty() const {
+        return m_source.empty();
+    }
+
+    /**      */
+    const vector<Segment>& segments() const {
+        return m_segments;
+    }
+
+    /**     */
+    const char* literalData(const Segment& segment) const {
+        return m_source.data() + segment.offset;
+    }
+
+    /**    (   ) */
+    size_t literalLength() const {
+        return m_literalLength;
+    }
+
+    /** ,        (  ,   )
+     * @param kind -  
+    */
+    bool uses(Kind kind) const {
+        return (m_tokens & (1u << kind)) != 0;
+    }
+
+    /**     
+     * @param values -   (  ,   uses() == true)
+     * @param out - ,    
+     * @param messageAt -    out ( ,     {m}).  : nullptr
+    */
+    void render(const Fields& values, string& out, size_t* messageAt = nullptr) const {
+        m_render(*this, values, out, messageAt);
+    }
+
+private:
+    string m_source;
+    vector<Segment> m_segments;
+    size_t m_literalLength;
+
+    /** :    (  ) */
+    unsigned m_tokens;
+
+    /**   :    (LOG_FORMAT)      */
+    Render m_render;
+
+    /**       ({S}   "src/<>") */
+    static size_t tokenSize(Kind kind, const Fields& values) {
+        return values.token[kind].size + (kind == source_token ? 4 : 0);
+    }
+
+    /**    */
+    static void appendToken(Kind kind, const Fields& values, string& out, size_t* messageAt) {
+        if (kind == message_token && messageAt) *messageAt = out.size();
+        if (kind == source_token) out.append("src/", 4);
+        out.append(values.token[kind].data, values.token[kind].size);
+    }
+
+    /**  ,    :    */
+    static void renderParsed(const LogFormat& format, const Fields& values, string& out, size_t* messageAt) {
+        const vector<Segment>& segments = format.m_segments;
+        size_t size = format.m_literalLength;
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (segments[i].kind != literal) size += tokenSize(segments[i].kind, values);
+        }
+        out.reserve(out.size() + size);
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (segments[i].kind == literal) out.append(format.literalData(segments[i]), segments[i].length);
+            else appendToken(segments[i].kind, values, out, messageAt);
+        }
+    }
+
+    /**      ;    */
+    void parse() {
+        size_t start = 0;
+        size_t i = 0;
+        while (i < m_source.size()) {
+            size_t length = tokenLength(m_source.c_str() + i);
+            if (length != 0) {
+                addLiteral(start, i);
+                Segment token = {kindOf(m_source.c_str() + i), i, length};
+                addSegment(token);
+                i += length;
+                start = i;
+            }
+            else {
+                i++;
+            }
+        }
+        addLiteral(start, i);
+    }
+
+    void addLiteral(size_t from, size_t to) {
+        if (to <= from) return;
+        Segment segment = {literal, from, to - from};
+        addSegment(segment);
+    }
+
+    void addSegment(const Segment& segment) {
+        m_segments.push_back(segment);
+        if (segment.kind == literal) m_literalLength += segment.length;
+        else m_tokens |= 1u << segment.kind;
+    }
+};
+
+template <class... Steps>
+constexpr LogFormat::Segment LogFormat::Compiled<Steps...>::table[sizeof...(Steps)];
+
+/**   i ,    (  LOG_FORMAT) */
+#define LOG_FORMAT_STEP(format, i) \
+    LogFormat::Step<LogFormat::kindAt(format, i), LogFormat::offsetAt(format, i), LogFormat::lengthAt(format, i)>
+
+/** ,     . : LOG_FORMAT("{t} | {L} -> {m}") */
+#define LOG_FORMAT(format) LogFormat(format, LogFormat::Checked<LogFormat::check(format)>(), LogFormat::Compiled< \
+    LOG_FORMAT_STEP(format, 0), LOG_FORMAT_STEP(format, 1), LOG_FORMAT_STEP(format, 2), LOG_FORMAT_STEP(format, 3), \
+    LOG_FORMAT_STEP(format, 4), LOG_FORMAT_STEP(format, 5), LOG_FORMAT_STEP(format, 6), LOG_FORMAT_STEP(format, 7), \
+    LOG_FORMAT_STEP(format, 8), LOG_FORMAT_STEP(format, 9), LOG_FORMAT_STEP(format, 10), LOG_FORMAT_STEP(format, 11), \
+    LOG_FORMAT_STEP(format, 12), LOG_FORMAT_STEP(format, 13), LOG_FORMAT_STEP(format, 14), LOG_FORMAT_STEP(format, 15)>())
+
+/**  ,   ,    */
+#define LOGS_SET_FORMAT(format) Logs::getInstance()->setFormat(LOG_FORMAT(format))
+
+#endif // LOG_FORMAT_H
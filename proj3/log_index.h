@@ -0,0 +1,128 @@
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+using namespace std;
+
+/**   :       */
+struct LogIndexEntry {
+    uint64_t offset;    //       
+    uint64_t length;    //    
+    int64_t minTime;    //     ,   
+    int64_t maxTime;    //     ,   
+    uint32_t count;     //  
+    uint32_t levels;    //   :  (1 << )
+};
+
+/**    */
+struct LogIndexHeader {
+    char magic[8];      // "LOGIDX1"
+    uint32_t interval;  //    
+    uint32_t entrySize; // sizeof(LogIndexEntry)
+};
+
+/**      "<>.idx":   LogIndexEntry  
+ * interval  .   log_query      ,    .
+ *    ,   (  ),      
+ *   -     .    
+ *   :       .
+ */
+class LogIndexWriter {
+public:
+    /** @param logName -    ( - logName + ".idx")
+     * @param offset -     (  )
+     * @param interval -   
+    */
+    LogIndexWriter(const string& logName, long long offset, unsigned interval) : m_file(nullptr), m_offset((uint64_t)offset),
+        m_interval(interval ? interval : 1) {
+        memset(&m_block, 0, sizeof(m_block));
+        m_file = fopen(indexName(logName).c_str(), "ab");
+        if (m_file == nullptr) return;
+        fseek(m_file, 0, SEEK_END);
+        if (ftell(m_file) == 0) {
+            LogIndexHeader header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, "LOGIDX1", 8);
+            header.interval = m_interval;
+            header.entrySize = sizeof(LogIndexEntry);
+            fwrite(&header, sizeof(header), 1, m_file);
+        }
+    }
+
+    LogIndexWriter(const LogIndexWriter&) = delete;
+    LogIndexWriter& operator=(const LogIndexWriter&) = delete;
+
+    /** :      */
+    ~LogIndexWriter() {
+        if (m_file == nullptr) return;
+        if (m_block.count > 0) writeBlock();
+        fclose(m_file);
+    }
+
+    bool isOpen() const {
+        return m_file != nullptr;
+    }
+
+    /**  ,     
+     * @param level -  (0 - trace ... 4 - error)
+     * @param timeNs -  ,   
+     * @param length -     
+    */
+    void add(int level, long long timeNs, size_t length) {
+        if (m_block.count == 0) {
+            m_block.offset = m_offset;
+            m_block.minTime = m_block.maxTime = timeNs;
+        }
+        if (timeNs < m_block.minTime) m_block.minTime = timeNs;
+        if (timeNs > m_block.maxTime) m_block.maxTime = timeNs;
+        m_block.levels |= 1u << level;
+        m_block.count++;
+        m_offset += length;
+        m_block.length = m_offset - m_block.offset;
+        if (m_block.count >= m_interval) writeBlock();
+    }
+
+    /**       */
+    void flush() {
+        if (m_file) fflush(m_file);
+    }
+
+    static string indexName(const string& logName) {
+        return logName + ".idx";
+    }
+
+    /**  ;    (    ) 
+     * @param logName -   
+     * @param entries -   ()
+     * @return false,         
+    */
+    static bool read(const string& logName, vector<LogIndexEntry>& entries) {
+        entries.clear();
+        FILE* file = fopen(indexName(logName).c_str(), "rb");
+        if (file == nullptr) return false;
+        LogIndexHeader header;
+        bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "LOGIDX1", 8) == 0 &&
+            header.entrySize == sizeof(LogIndexEntry);
+        LogIndexEntry entry;
+        while (valid && fread(&entry, sizeof(entry), 1, file) == 1) entries.push_back(entry);
+        fclose(file);
+        return valid;
+    }
+
+private:
+    FILE* m_file;
+    uint64_t m_offset;
+    unsigned m_interval;
+    LogIndexEntry m_block;
+
+    void writeBlock() {
+        if (m_file) fwrite(&m_block, sizeof(m_block), 1, m_file);
+        memset(&m_block, 0, sizeof(m_block));
+    }
+};
+
+#endif // LOG_INDEX_H
@@ -0,0 +1,563 @@
+#ifndef LOG_NET_SINK_H
+#define LOG_NET_SINK_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+#include "log_sink.h"
+#include "log_file_sink.h"
+
+#ifdef _WIN32
+//    Windows   ws2_32 (-lws2_32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+using namespace std;
+
+/**     :    ()  UDP/TCP.
+ * :
+ *  - syslog_udp - RFC5424,    ,     sendmmsg (Linux);
+ *  - syslog_tcp - RFC5424    (RFC6587),   -  ;
+ *  - framed_tcp - : 4   (big-endian) +    .
+ *  , flush()   : ,     ,  
+ *   (. LogSink::pending),     flush_timeout_ms    .
+ *         (spillFile) -  ,    
+ * ,        .  
+ *    (backoff).
+ *     (. Logs::addSink),    .
+ */
+class NetworkSink : public LogSink {
+public:
+    /**   . : (NetworkSink::framed_tcp) */
+    enum Protocol {syslog_udp, syslog_tcp, framed_tcp};
+
+private:
+#ifdef _WIN32
+    typedef SOCKET socket_t;
+#else
+    typedef int socket_t;
+#endif
+    typedef chrono::steady_clock clock_type;
+
+    /** ,  :          */
+    struct Frame {
+        string wire;
+        string plain;
+        vector<size_t> ends;        //    wire ( syslog)
+        vector<size_t> plainEnds;   //      plain ( syslog)
+        size_t records;
+    };
+
+    /**     flush(), ;      */
+    static const int flush_timeout_ms = 100;
+
+    string m_host;
+    string m_port;
+    Protocol m_protocol;
+    string m_appName;
+    string m_hostname;
+    size_t m_frameSize;
+    size_t m_maxPending;
+
+    socket_t m_socket;
+    bool m_connected;
+    bool m_connecting;
+    clock_type::time_point m_nextAttempt;
+    chrono::milliseconds m_backoff;
+    chrono::milliseconds m_minBackoff;
+    chrono::milliseconds m_maxBackoff;
+
+    Frame m_batch;
+    deque<Frame> m_frames;
+    size_t m_sentInFront;       //   (TCP)   (UDP)    
+    size_t m_pendingBytes;
+    clock_type::time_point m_flushDeadline;     //    flush(); 0 -  
+
+    string m_spillFile;
+    FileSink* m_spill;
+
+    time_t m_stampTime;
+    string m_stamp;
+
+    unsigned long long m_sentRecords;
+    unsigned long long m_sentBytes;
+    unsigned long long m_spilledRecords;
+    unsigned long long m_droppedRecords;
+    unsigned long long m_reconnects;
+
+    static bool isValid(socket_t s) {
+#ifdef _WIN32
+        return s != INVALID_SOCKET;
+#else
+        return s >= 0;
+#endif
+    }
+
+    static void closeSocket(socket_t s) {
+#ifdef _WIN32
+        closesocket(s);
+#else
+        ::close(s);
+#endif
+    }
+
+    static int lastError() {
+#ifdef _WIN32
+        return WSAGetLastError();
+#else
+        return errno;
+#endif
+    }
+
+    static bool wouldBlock(int err) {
+#ifdef _WIN32
+        return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS;
+#else
+        return err == EAGAIN || err == EWOULDBLOCK || err == EINPROGRESS || err == EINTR;
+#endif
+    }
+
+    static bool setNonBlocking(socket_t s) {
+#ifdef _WIN32
+        u_long mode = 1;
+        return ioctlsocket(s, FIONBIO, &mode) == 0;
+#else
+        int flags = fcntl(s, F_GETFL, 0);
+        return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+    }
+
+    /**      SIGPIPE */
+    int sendSome(const char* data, size_t len) {
+#ifdef _WIN32
+        return ::send(m_socket, data, (int)len, 0);
+#else
+        return (int)::send(m_socket, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+#endif
+    }
+
+    /**     RFC3339 (UTC),    */
+    const string& getStamp() {
+        time_t now = time(0);
+        if (now != m_stampTime) {
+            char buf[32];
+            strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+            m_stamp = buf;
+            m_stampTime = now;
+        }
+        return m_stamp;
+    }
+
+    /**     severity syslog */
+    static int syslogSeverity(int level) {
+        switch (level) {
+        case 4: return 3;   // error -> err
+        case 3: return 4;   // warning -> warning
+        case 2: return 6;   // info -> informational
+        default: return 7;  // debug, trace -> debug
+        }
+    }
+
+    /**  ().  :  TCP     */
+    void tryConnect() {
+        if (m_connected) return;
+        if (m_connecting) {
+            checkConnecting();
+            return;
+        }
+        if (clock_type::now() < m_nextAttempt) return;
+
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = (m_protocol == syslog_udp) ? SOCK_DGRAM : SOCK_STREAM;
+        addrinfo* res = nullptr;
+        if (getaddrinfo(m_host.c_str(), m_port.c_str(), &hints, &res) != 0 || res == nullptr) {
+            connectFailed();
+            return;
+        }
+        m_socket = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        if (!isValid(m_socket) || !setNonBlocking(m_socket)) {
+            freeaddrinfo(res);
+            connectFailed();
+            return;
+        }
+        if (m_protocol != syslog_udp) {
+            int one = 1;
+            setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+        }
+        int rc = ::connect(m_socket, res->ai_addr, (int)res->ai_addrlen);
+        freeaddrinfo(res);
+        if (rc == 0) {
+            connectSucceeded();
+        }
+        else if (wouldBlock(lastError())) {
+            m_connecting = true;
+            checkConnecting();
+        }
+        else {
+            connectFailed();
+        }
+    }
+
+    /**    connect() */
+    void checkConnecting() {
+#ifdef _WIN32
+        fd_set wr, ex;
+        FD_ZERO(&wr); FD_ZERO(&ex);
+        FD_SET(m_socket, &wr); FD_SET(m_socket, &ex);
+        timeval tv = {0, 0};
+        if (select(0, NULL, &wr, &ex, &tv) <= 0) return;
+#else
+        pollfd pfd;
+        pfd.fd = m_socket;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 0) <= 0) return;
+#endif
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(m_socket, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+        m_connecting = false;
+        if (err == 0) connectSucceeded();
+        else connectFailed();
+    }
+
+    void connectSucceeded() {
+        m_connected = true;
+        m_connecting = false;
+        m_backoff = m_minBackoff;
+        m_reconnects++;
+    }
+
+    /**    :         */
+    void connectFailed() {
+        if (isValid(m_socket)) closeSocket(m_socket);
+#ifdef _WIN32
+        m_socket = INVALID_SOCKET;
+#else
+        m_socket = -1;
+#endif
+        m_connected = false;
+        m_connecting = false;
+        m_nextAttempt = clock_type::now() + m_backoff;
+        m_backoff = (m_backoff * 2 > m_maxBackoff) ? m_maxBackoff : m_backoff * 2;
+    }
+
+    /**        .
+     *  framed_tcp   ,    - 0.
+    */
+    size_t deliveredInFront(const Frame& f) const {
+        if (m_protocol == syslog_udp) return m_sentInFront;
+        if (m_protocol == framed_tcp) return 0;
+        size_t n = 0;
+        while (n < f.ends.size() && f.ends[n] <= m_sentInFront) n++;
+        return n;
+    }
+
+    /**        (    ).
+     *      ,     .
+    */
+    void spillAll() {
+        bool front = true;
+        while (!m_frames.empty()) {
+            Frame& f = m_frames.front();
+            size_t delivered = front ? deliveredInFront(f) : 0;
+            size_t from = delivered ? f.plainEnds[delivered - 1] : 0;
+            m_sentRecords += delivered;
+            if (!m_spillFile.empty()) {
+                if (m_spill == nullptr) m_spill = new FileSink(m_spillFile, 256 * 1024, 2);
+                m_spill->write(f.plain.data() + from, f.plain.size() - from);
+                m_spilledRecords += f.records - delivered;
+            }
+            else {
+                m_droppedRecords += f.records - delivered;
+            }
+            m_pendingBytes -= f.wire.size();
+            m_frames.pop_front();
+            front = false;
+        }
+        m_sentInFront = 0;
+        m_flushDeadline = clock_type::time_point();
+    }
+
+    /**   ,    */
+    void pump() {
+        if (m_frames.empty()) return;
+        tryConnect();
+        if (!m_connected) {
+            //   ,     ,     
+            if (!m_connecting) spillAll();
+            return;
+        }
+        if (m_protocol == syslog_udp) pumpDatagrams();
+        else pumpStream();
+        //   :   ,       
+        if (m_pendingBytes > m_maxPending) {
+            connectFailed();
+            spillAll();
+        }
+    }
+
+    void pumpStream() {
+        while (!m_frames.empty()) {
+            Frame& f = m_frames.front();
+            int n = sendSome(f.wire.data() + m_sentInFront, f.wire.size() - m_sentInFront);
+            if (n < 0) {
+                if (wouldBlock(lastError())) return;
+                connectFailed();
+                spillAll();
+                return;
+            }
+            m_sentInFront += n;
+            m_sentBytes += n;
+            if (m_sentInFront < f.wire.size()) continue;
+            m_sentRecords += f.records;
+            m_pendingBytes -= f.wire.size();
+            m_sentInFront = 0;
+            m_frames.pop_front();
+        }
+    }
+
+    void pumpDatagrams() {
+        while (!m_frames.empty()) {
+            Frame& f = m_frames.front();
+            while (m_sentInFront < f.ends.size()) {
+                size_t start = m_sentInFront ? f.ends[m_sentInFront - 1] : 0;
+#if defined(__linux__)
+                //     
+                const size_t max_batch = 64;
+                mmsghdr msgs[max_batch];
+                iovec iov[max_batch];
+                unsigned count = 0;
+                for (size_t i = m_sentInFront; i < f.ends.size() && count < max_batch; i++, count++) {
+                    size_t begin = i ? f.ends[i - 1] : 0;
+                    iov[count].iov_base = (void*)(f.wire.data() + begin);
+                    iov[count].iov_len = f.ends[i] - begin;
+                    memset(&msgs[count], 0, sizeof(mmsghdr));
+                    msgs[count].msg_hdr.msg_iov = &iov[count];
+                    msgs[count].msg_hdr.msg_iovlen = 1;
+                }
+                int n = sendmmsg(m_socket, msgs, count, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (n > 0) {
+                    m_sentBytes += f.ends[m_sentInFront + n - 1] - start;
+                    m_sentInFront += n;
+                    continue;
+                }
+#else
+                int n = sendSome(f.wire.data() + start, f.ends[m_sentInFront] - start);
+                if (n >= 0) {
+                    m_sentBytes += n;
+                    m_sentInFront++;
+                    continue;
+                }
+#endif
+                if (wouldBlock(lastError())) return;
+                // ECONNREFUSED  ..:  
+                connectFailed();
+                spillAll();
+                return;
+            }
+            m_sentRecords += f.records;
+            m_pendingBytes -= f.wire.size();
+            m_sentInFront = 0;
+            m_frames.pop_front();
+        }
+    }
+
+    /**            */
+    void closeBatch() {
+        if (m_batch.records == 0) return;
+        if (m_protocol == framed_tcp) {
+            unsigned len = (unsigned)(m_batch.wire.size() - 4);
+            m_batch.wire[0] = (char)((len >> 24) & 0xFF);
+            m_batch.wire[1] = (char)((len >> 16) & 0xFF);
+            m_batch.wire[2] = (char)((len >> 8) & 0xFF);
+            m_batch.wire[3] = (char)(len & 0xFF);
+        }
+        m_pendingBytes += m_batch.wire.size();
+        m_frames.push_back(Frame());
+        m_frames.back().wire.swap(m_batch.wire);
+        m_frames.back().plain.swap(m_batch.plain);
+        m_frames.back().ends.swap(m_batch.ends);
+        m_frames.back().plainEnds.swap(m_batch.plainEnds);
+        m_frames.back().records = m_batch.records;
+        resetBatch();
+    }
+
+    void resetBatch() {
+        m_batch.wire.clear();
+        m_batch.plain.clear();
+        m_batch.ends.clear();
+        m_batch.plainEnds.clear();
+        m_batch.records = 0;
+        if (m_protocol == framed_tcp) m_batch.wire.assign(4, '\0'); //    
+    }
+
+public:
+    /**    (    )
+     * @param host -  
+     * @param port -  
+     * @param protocol - .  : framed_tcp
+     * @param spillFile -      .  : "" ( )
+     * @param frameSize -    ,    .  : 64 
+     * @param appName - APP-NAME   syslog.  : "proj_logger"
+    */
+    NetworkSink(const string& host, int port, Protocol protocol = framed_tcp, const string& spillFile = "",
+                size_t frameSize = 64 * 1024, const string& appName = "proj_logger")
+        : m_host(host), m_port(to_string(port)), m_protocol(protocol), m_appName(appName), m_hostname("-"),
+          m_frameSize(frameSize), m_maxPending(64 * frameSize), m_connected(false), m_connecting(false),
+          m_nextAttempt(clock_type::now()), m_backoff(100), m_minBackoff(100), m_maxBackoff(30000),
+          m_sentInFront(0), m_pendingBytes(0), m_spillFile(spillFile), m_spill(nullptr), m_stampTime(0),
+          m_sentRecords(0), m_sentBytes(0), m_spilledRecords(0), m_droppedRecords(0), m_reconnects(0) {
+#ifdef _WIN32
+        WSADATA wsa;
+        WSAStartup(MAKEWORD(2, 2), &wsa);
+        m_socket = INVALID_SOCKET;
+#else
+        m_socket = -1;
+#endif
+        char name[256];
+        if (gethostname(name, sizeof(name)) == 0) {
+            name[sizeof(name) - 1] = '\0';
+            m_hostname = name;
+        }
+        resetBatch();
+    }
+
+    NetworkSink(const NetworkSink&) = delete;
+    NetworkSink& operator=(const NetworkSink&) = delete;
+
+    ~NetworkSink() {
+        drain();
+        if (isValid(m_socket)) closeSocket(m_socket);
+        delete m_spill;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    /**   
+     * @param minMs -    , 
+     * @param maxMs -  , 
+    */
+    void setBackoff(int minMs, int maxMs) {
+        m_minBackoff = chrono::milliseconds(minMs);
+        m_maxBackoff = chrono::milliseconds(maxMs);
+        m_backoff = m_minBackoff;
+    }
+
+    /**    */
+    bool isConnected() const {
+        return m_connected;
+    }
+
+    /** :   / ,    , ,  */
+    unsigned long long sentRecords() const { return m_sentRecords; }
+    unsigned long long sentBytes() const { return m_sentBytes; }
+    unsigned long long spilledRecords() const { return m_spilledRecords; }
+    unsigned long long droppedRecords() const { return m_droppedRecords; }
+    unsigned long long reconnects() const { return m_reconnects; }
+
+    void write(const char* data, size_t len) override {
+        writeRecord(2, data, len);
+    }
+
+    void writeRecord(int level, const char* data, size_t len) override {
+        //        syslog  
+        size_t body = len;
+        while (body > 0 && (data[body - 1] == '\n' || data[body - 1] == '\r')) body--;
+        m_batch.plain.append(data, len);
+        if (m_protocol == framed_tcp) {
+            m_batch.wire.append(data, len);
+        }
+        else {
+            char head[64];
+            // PRI = facility user (1) * 8 + severity
+            snprintf(head, sizeof(head), "<%d>1 ", 8 + syslogSeverity(level));
+            string msg = head;
+            msg += getStamp();
+            msg += ' ';
+            msg += m_hostname;
+            msg += ' ';
+            msg += m_appName;
+            msg += " - - - ";
+            msg.append(data, body);
+            if (m_protocol == syslog_tcp) {
+                m_batch.wire += to_string(msg.size());
+                m_batch.wire += ' ';
+            }
+            m_batch.wire += msg;
+            m_batch.ends.push_back(m_batch.wire.size());
+            m_batch.plainEnds.push_back(m_batch.plain.size());
+        }
+        m_batch.records++;
+        if (m_batch.wire.size() >= m_frameSize) {
+            closeBatch();
+            pump();
+        }
+    }
+
+    /**      .    ,  
+     *  flush();   flush_timeout_ms     ,     
+    */
+    void flush() override {
+        closeBatch();
+        pump();
+        if (m_frames.empty()) m_flushDeadline = clock_type::time_point();
+        else if (m_flushDeadline == clock_type::time_point()) {
+            m_flushDeadline = clock_type::now() + chrono::milliseconds(flush_timeout_ms);
+        }
+        else if (clock_type::now() >= m_flushDeadline) {
+            if (m_connected) connectFailed();
+            spillAll();
+        }
+        if (m_spill) m_spill->flush();
+    }
+
+    bool pending() const override {
+        return !m_frames.empty();
+    }
+
+private:
+    /**      :    flush_timeout_ms */
+    void drain() {
+        closeBatch();
+        pump();
+        for (int i = 0; i < flush_timeout_ms && !m_frames.empty(); i++) {
+#ifdef _WIN32
+            Sleep(1);
+#else
+            if (m_connected) {
+                pollfd pfd;
+                pfd.fd = m_socket;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                poll(&pfd, 1, 1);
+            }
+            else usleep(1000);
+#endif
+            pump();
+        }
+        if (!m_frames.empty()) {
+            if (m_connected) connectFailed();
+            spillAll();
+        }
+        if (m_spill) m_spill->flush();
+    }
+};
+
+#endif // LOG_NET_SINK_H
@@ -0,0 +1,292 @@
+/**      ,        (. Logs::setIndex).
+ *  (Linux): g++ -std=gnu++11 -O2 -pthread log_query.cpp -o log_query
+ * : log_query [-from ] [-to ] [-l ] [-g ] [-j ] [-c] ...
+ *  -from, -to -    "-- ::" ();  : "2023-09-22 12"
+ *  -l     -  : trace, debug, info, warning, error.  : 
+ *  -g     -    
+ *  -j     -   .  :  
+ *  -c     -     
+ *  (,   )    .    ,
+ *             .
+ *           .
+ *      ,       ("{t} | {L} ...");
+ *         .
+ *  (    )   stderr.
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <ctime>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "log_index.h"
+using namespace std;
+
+/**   */
+struct Query {
+    string from;            //     (    )
+    string to;              //  
+    long long fromNs;       //        ( )
+    long long toNs;
+    unsigned levels;        //  :  (1 << )
+    string substring;
+    bool countOnly;
+};
+
+/**  ,    */
+struct MappedFile {
+    string name;
+    const char* data;
+    size_t size;
+};
+
+/**       */
+struct Task {
+    size_t file;
+    size_t begin;
+    size_t end;
+    string output;
+    unsigned long long found;
+};
+
+static const char* level_names[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR"};
+
+/**   "-- ::" (, )    ,   
+ * @param text - 
+ * @param upper - true -   , false - 
+*/
+static long long parseTime(const string& text, bool upper) {
+    string full = text + string(upper ? "9999-12-31 23:59:59" : "0000-01-01 00:00:00").substr(min(text.size(), (size_t)19));
+    tm t;
+    memset(&t, 0, sizeof(t));
+    if (sscanf(full.c_str(), "%d-%d-%d %d:%d:%d", &t.tm_year, &t.tm_mon, &t.tm_mday, &t.tm_hour, &t.tm_min, &t.tm_sec) != 6) return upper ? LLONG_MAX : LLONG_MIN;
+    if (t.tm_year > 3000) return LLONG_MAX;
+    if (t.tm_year < 1900) return LLONG_MIN;
+    t.tm_year -= 1900;
+    t.tm_mon -= 1;
+    t.tm_isdst = -1;
+    long long seconds = (long long)mktime(&t);
+    return upper ? (seconds + 1) * 1000000000LL - 1 : seconds * 1000000000LL;
+}
+
+/**      : "-- :: |  ..."; -1 -   */
+static int lineLevel(const char* line, size_t len) {
+    if (len < 23 || memcmp(line + 19, " | ", 3) != 0) return -1;
+    for (int i = 0; i < 5; i++) {
+        size_t n = strlen(level_names[i]);
+        if (len >= 22 + n && memcmp(line + 22, level_names[i], n) == 0) return i;
+    }
+    return -1;
+}
+
+/**       (     ) */
+static int comparePrefix(const char* line, size_t len, const string& bound) {
+    size_t n = min(len, bound.size());
+    int c = memcmp(line, bound.data(), n);
+    if (c != 0) return c;
+    return n < bound.size() ? -1 : 0;
+}
+
+/**    ,    */
+static bool matches(const Query& q, const char* line, size_t len) {
+    bool dated = len >= 19 && line[4] == '-' && line[13] == ':';
+    if (dated && !q.from.empty() && comparePrefix(line, len, q.from) < 0) return false;
+    if (dated && !q.to.empty() && comparePrefix(line, len, q.to) > 0) return false;
+    if (q.levels != 0x1F) {
+        int level = lineLevel(line, len);
+        if (level >= 0 && !(q.levels & (1u << level))) return false;
+    }
+    if (!q.substring.empty()) {
+        const char* p = (const char*)memmem(line, len, q.substring.data(), q.substring.size());
+        if (p == nullptr) return false;
+    }
+    return true;
+}
+
+/**     */
+static void scan(const Query& q, const MappedFile& f, Task& task) {
+    const char* p = f.data + task.begin;
+    const char* end = f.data + task.end;
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = nl ? nl : end;
+        size_t len = lineEnd - p;
+        if (len > 0 && p[len - 1] == '\r') len--;
+        if (len > 0 && matches(q, p, len)) {
+            task.found++;
+            if (!q.countOnly) {
+                task.output.append(p, len);
+                task.output += '\n';
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+/**    :    parts     */
+static void splitFile(size_t file, const MappedFile& f, size_t begin, size_t parts, vector<Task>& tasks) {
+    size_t step = (f.size - begin) / parts + 1;
+    while (begin < f.size) {
+        size_t end = begin + step < f.size ? begin + step : f.size;
+        const char* nl = end < f.size ? (const char*)memchr(f.data + end, '\n', f.size - end) : nullptr;
+        end = nl ? (size_t)(nl - f.data) + 1 : f.size;
+        Task t = {file, begin, end, string(), 0};
+        tasks.push_back(t);
+        begin = end;
+    }
+}
+
+/**   .
+ *       ,    (  ),   
+ *     maxTime ( ,      from)  
+ *     minTime ( ,      to).
+ *      ;     ,
+ *   ,       .
+ * @return ,       
+*/
+static size_t selectBlocks(const Query& q, size_t file, const MappedFile& f, const vector<LogIndexEntry>& entries,
+    vector<Task>& tasks, unsigned long long& skipped) {
+    size_t n = 0;
+    size_t covered = 0;
+    vector<long long> prefixMax(entries.size());
+    vector<Task> gaps;
+    for (; n < entries.size(); n++) {
+        const LogIndexEntry& e = entries[n];
+        if (e.offset + e.length > f.size) break;
+        //    (,  ,   )  
+        if (e.offset > covered) {
+            Task gap = {file, covered, (size_t)e.offset, string(), 0};
+            gaps.push_back(gap);
+        }
+        covered = (size_t)(e.offset + e.length);
+        prefixMax[n] = max(n ? prefixMax[n - 1] : LLONG_MIN, (long long)e.maxTime);
+    }
+    prefixMax.resize(n);
+    vector<long long> suffixMin(n);
+    for (size_t i = n; i-- > 0;) suffixMin[i] = min(i + 1 < n ? suffixMin[i + 1] : LLONG_MAX, (long long)entries[i].minTime);
+    size_t first = lower_bound(prefixMax.begin(), prefixMax.end(), q.fromNs) - prefixMax.begin();
+    size_t last = upper_bound(suffixMin.begin(), suffixMin.end(), q.toNs) - suffixMin.begin();
+    if (last < first) last = first;
+    skipped += n - (last - first);
+    size_t g = 0;
+    for (size_t i = first; i < last; i++) {
+        const LogIndexEntry& e = entries[i];
+        if (!(e.levels & q.levels) || e.maxTime < q.fromNs || e.minTime > q.toNs) {
+            skipped++;
+            continue;
+        }
+        for (; g < gaps.size() && gaps[g].begin < e.offset; g++) tasks.push_back(gaps[g]);
+        Task t = {file, (size_t)e.offset, (size_t)(e.offset + e.length), string(), 0};
+        tasks.push_back(t);
+    }
+    for (; g < gaps.size(); g++) tasks.push_back(gaps[g]);
+    return covered;
+}
+
+static int usage() {
+    cout << "log_query [-from ] [-to ] [-l ] [-g ] [-j ] [-c] ..." << endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    Query q;
+    q.levels = 0x1F;
+    q.countOnly = false;
+    unsigned threads = thread::hardware_concurrency();
+    vector<string> names;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool value = i + 1 < argc;
+        if (arg == "-from" && value) q.from = argv[++i];
+        else if (arg == "-to" && value) q.to = argv[++i];
+        else if (arg == "-g" && value) q.substring = argv[++i];
+        else if (arg == "-j" && value) threads = (unsigned)atoi(argv[++i]);
+        else if (arg == "-c") q.countOnly = true;
+        else if (arg == "-l" && value) {
+            string level = argv[++i];
+            for (size_t k = 0; k < level.size(); k++) level[k] = (char)toupper(level[k]);
+            int lv = -1;
+            for (int k = 0; k < 5; k++) {
+                if (level == level_names[k]) lv = k;
+            }
+            if (lv < 0) return usage();
+            q.levels = 0x1Fu & ~((1u << lv) - 1);
+        }
+        else if (arg[0] == '-') return usage();
+        else names.push_back(arg);
+    }
+    if (names.empty()) return usage();
+    if (threads == 0) threads = 1;
+    q.fromNs = q.from.empty() ? LLONG_MIN : parseTime(q.from, false);
+    q.toNs = q.to.empty() ? LLONG_MAX : parseTime(q.to, true);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<MappedFile> files;
+    vector<Task> tasks;
+    unsigned long long blocks = 0, skipped = 0, total = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        MappedFile f = {names[i], nullptr, 0};
+        int fd = open(names[i].c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            cerr << ":    " << names[i] << endl;
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        f.size = (size_t)st.st_size;
+        if (f.size > 0) {
+            void* p = mmap(nullptr, f.size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                f.data = (const char*)p;
+                madvise(p, f.size, MADV_RANDOM);
+            }
+        }
+        close(fd);
+        if (f.data == nullptr) continue;
+        total += f.size;
+        files.push_back(f);
+        size_t file = files.size() - 1;
+        vector<LogIndexEntry> entries;
+        size_t tail = 0;
+        if (LogIndexWriter::read(names[i], entries)) {
+            blocks += entries.size();
+            tail = selectBlocks(q, file, f, entries, tasks, skipped);
+        }
+        //    (    )   
+        if (tail < f.size) splitFile(file, f, tail, tail == 0 ? threads : 1, tasks);
+    }
+
+    atomic<size_t> next(0);
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.push_back(thread([&]() {
+            for (size_t k = next++; k < tasks.size(); k = next++) scan(q, files[tasks[k].file], tasks[k]);
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+    unsigned long long found = 0, scanned = 0;
+    for (size_t k = 0; k < tasks.size(); k++) {
+        found += tasks[k].found;
+        scanned += tasks[k].end - tasks[k].begin;
+        if (!q.countOnly) fwrite(tasks[k].output.data(), 1, tasks[k].output.size(), stdout);
+    }
+    if (q.countOnly) printf("%llu\n", found);
+    fflush(stdout);
+    for (size_t i = 0; i < files.size(); i++) munmap((void*)files[i].data, files[i].size);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "found %llu lines; index blocks %llu, skipped %llu; scanned %llu of %llu bytes in %.3f s\n",
+        found, blocks, skipped, scanned, total, seconds);
+    return 0;
+}
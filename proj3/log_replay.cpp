@@ -0,0 +1,372 @@
+/**           .
+ *  (Linux): g++ -std=gnu++11 -O2 -pthread log_replay.cpp logs.cpp -o log_replay
+ *  : log_replay -record  .log...
+ * : log_replay [-t ] [-s ] [-m ] [-o ] [-baseline ] [-save ] [-tol %] 
+ *  -record  -      :   -      
+ *  -t       -  ,     ( ).  : 4
+ *  -s       -   : 1 -   , 10 -  10  , 0 -  .  : 1
+ *  -m       -   : queue, thread_local, topology.  : queue
+ *  -o       - ,    (  ).  : log_replay_out.log
+ *  -baseline -    ;     1
+ *  -save    -     
+ *  -tol     -  , %.  : 10
+ *  -  (-record)        ("{t} | {L} ... -> {m}"),  ,
+ *   writeFile.       :     
+ *    ,      ,    .
+ * :      ,   write()  
+ * (p50/p99/p999/max),   (   ,  )   RSS.
+ */
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <climits>
+#include <sys/resource.h>
+#include "logs.h"
+using namespace std;
+
+typedef chrono::steady_clock clock_type;
+
+static const char* level_names[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR"};
+
+/**  : count   level  size   second */
+struct ProfileEntry {
+    long long second;
+    int level;
+    size_t size;
+    unsigned long long count;
+};
+
+/**    */
+struct Event {
+    long long offsetNs;     //       1
+    int level;
+    size_t size;
+};
+
+/**   (  ) */
+struct Result {
+    double throughput;      //      flush
+    double p50;             //  write(), 
+    double p99;
+    double p999;
+    double dropped;         //     
+    double rssKb;           //  RSS, 
+};
+
+/**  "-- ::"   ( ); -1,       */
+static long long parseTime(const char* line, size_t len) {
+    if (len < 19 || line[4] != '-' || line[7] != '-' || line[10] != ' ' || line[13] != ':' || line[16] != ':') return -1;
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    t.tm_year = atoi(line) - 1900;
+    t.tm_mon = atoi(line + 5) - 1;
+    t.tm_mday = atoi(line + 8);
+    t.tm_hour = atoi(line + 11);
+    t.tm_min = atoi(line + 14);
+    t.tm_sec = atoi(line + 17);
+    t.tm_isdst = -1;
+    return (long long)mktime(&t);
+}
+
+/**       ( " | "); -1,    */
+static int parseLevel(const char* line, size_t len) {
+    for (int i = 4; i >= 0; i--) {
+        size_t n = strlen(level_names[i]);
+        if (len >= 22 + n && memcmp(line + 19, " | ", 3) == 0 && memcmp(line + 22, level_names[i], n) == 0) return i;
+    }
+    return -1;
+}
+
+/**     .       ( 
+ * )     .
+ * @return false,        
+*/
+static bool readLogs(const vector<string>& names, vector<ProfileEntry>& profile) {
+    struct Item {
+        long long second;
+        int level;
+        size_t size;
+    };
+    vector<Item> items;
+    long long first = LLONG_MAX;
+    for (size_t f = 0; f < names.size(); f++) {
+        ifstream in(names[f].c_str(), ios::binary);
+        if (!in.is_open()) {
+            cerr << "   " << names[f] << endl;
+            continue;
+        }
+        string line;
+        while (getline(in, line)) {
+            if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+            long long second = parseTime(line.data(), line.size());
+            int level = second < 0 ? -1 : parseLevel(line.data(), line.size());
+            size_t arrow = level < 0 ? string::npos : line.find(" -> ", 22);
+            if (arrow == string::npos) {
+                if (!items.empty()) items.back().size += line.size() + 1;
+                continue;
+            }
+            Item item = {second, level, line.size() - arrow - 4};
+            items.push_back(item);
+            if (second < first) first = second;
+        }
+    }
+    if (items.empty()) return false;
+    //        -   
+    map<long long, map<pair<int, size_t>, unsigned long long> > seconds;
+    for (size_t i = 0; i < items.size(); i++) seconds[items[i].second - first][make_pair(items[i].level, items[i].size)]++;
+    profile.clear();
+    for (map<long long, map<pair<int, size_t>, unsigned long long> >::iterator s = seconds.begin(); s != seconds.end(); ++s) {
+        for (map<pair<int, size_t>, unsigned long long>::iterator it = s->second.begin(); it != s->second.end(); ++it) {
+            ProfileEntry entry = {s->first, it->first.first, it->first.second, it->second};
+            profile.push_back(entry);
+        }
+    }
+    return true;
+}
+
+static bool writeProfile(const string& name, const vector<ProfileEntry>& profile) {
+    FILE* file = fopen(name.c_str(), "w");
+    if (file == nullptr) return false;
+    fprintf(file, "# log_replay profile 1\n#    \n");
+    for (size_t i = 0; i < profile.size(); i++) {
+        fprintf(file, "%lld %d %zu %llu\n", profile[i].second, profile[i].level, profile[i].size, profile[i].count);
+    }
+    return fclose(file) == 0;
+}
+
+/**  ; false,   -   */
+static bool readProfile(const string& name, vector<ProfileEntry>& profile) {
+    ifstream in(name.c_str());
+    string line;
+    if (!getline(in, line) || line.compare(0, 21, "# log_replay profile ") != 0) return false;
+    profile.clear();
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        ProfileEntry entry;
+        if (sscanf(line.c_str(), "%lld %d %zu %llu", &entry.second, &entry.level, &entry.size, &entry.count) != 4) continue;
+        if (entry.level < 0 || entry.level > 4) continue;
+        profile.push_back(entry);
+    }
+    return true;
+}
+
+/**    : count     ,    */
+static vector<Event> expand(const vector<ProfileEntry>& profile) {
+    vector<Event> events;
+    unsigned long long random = 88172645463325252ULL;
+    size_t i = 0;
+    while (i < profile.size()) {
+        size_t begin = events.size();
+        long long second = profile[i].second;
+        for (; i < profile.size() && profile[i].second == second; i++) {
+            for (unsigned long long k = 0; k < profile[i].count; k++) {
+                Event e = {0, profile[i].level, profile[i].size};
+                events.push_back(e);
+            }
+        }
+        size_t n = events.size() - begin;
+        for (size_t k = n; k > 1; k--) {
+            random ^= random << 13;
+            random ^= random >> 7;
+            random ^= random << 17;
+            swap(events[begin + k - 1], events[begin + random % k]);
+        }
+        for (size_t k = 0; k < n; k++) events[begin + k].offsetNs = second * 1000000000LL + (long long)((k + 0.5) * 1e9 / n);
+    }
+    return events;
+}
+
+static unsigned long long countLines(const string& name) {
+    FILE* file = fopen(name.c_str(), "rb");
+    if (file == nullptr) return 0;
+    unsigned long long lines = 0;
+    char buffer[1 << 16];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        for (size_t i = 0; i < n; i++) lines += buffer[i] == '\n';
+    }
+    fclose(file);
+    return lines;
+}
+
+static double percentile(const vector<unsigned>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static bool readBaseline(const string& name, Result& r) {
+    ifstream in(name.c_str());
+    if (!in.is_open()) return false;
+    map<string, double> values;
+    string key;
+    double value;
+    while (in >> key >> value) values[key] = value;
+    if (values.size() < 6) return false;
+    r.throughput = values["throughput"];
+    r.p50 = values["p50"];
+    r.p99 = values["p99"];
+    r.p999 = values["p999"];
+    r.dropped = values["dropped"];
+    r.rssKb = values["rss_kb"];
+    return true;
+}
+
+static bool writeBaseline(const string& name, const Result& r) {
+    FILE* file = fopen(name.c_str(), "w");
+    if (file == nullptr) return false;
+    fprintf(file, "throughput %.1f\np50 %.0f\np99 %.0f\np999 %.0f\ndropped %.0f\nrss_kb %.0f\n",
+            r.throughput, r.p50, r.p99, r.p999, r.dropped, r.rssKb);
+    return fclose(file) == 0;
+}
+
+/**    
+ * @param higherIsBetter - true   
+ * @return true,    
+*/
+static bool compare(const char* name, double current, double base, double tolerance, bool higherIsBetter) {
+    double change = base != 0 ? (current - base) / base * 100.0 : 0;
+    bool regression = higherIsBetter ? current < base * (1 - tolerance / 100.0) : current > base * (1 + tolerance / 100.0);
+    printf("%-12s %14.1f %14.1f %+9.1f%%  %s\n", name, current, base, change, regression ? "REGRESSION" : "ok");
+    return regression;
+}
+
+static int usage() {
+    cout << "log_replay -record  .log..." << endl;
+    cout << "log_replay [-t ] [-s ] [-m queue|thread_local|topology] [-o ] "
+            "[-baseline ] [-save ] [-tol %] |.log..." << endl;
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    string recordTo, output = "log_replay_out.log", baseline, saveTo, mode = "queue";
+    int threads = 4;
+    double speed = 1.0, tolerance = 10.0;
+    vector<string> inputs;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool value = i + 1 < argc;
+        if (arg == "-record" && value) recordTo = argv[++i];
+        else if (arg == "-t" && value) threads = atoi(argv[++i]);
+        else if (arg == "-s" && value) speed = atof(argv[++i]);
+        else if (arg == "-m" && value) mode = argv[++i];
+        else if (arg == "-o" && value) output = argv[++i];
+        else if (arg == "-baseline" && value) baseline = argv[++i];
+        else if (arg == "-save" && value) saveTo = argv[++i];
+        else if (arg == "-tol" && value) tolerance = atof(argv[++i]);
+        else if (arg[0] == '-') return usage();
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty() || threads <= 0 || speed < 0) return usage();
+    if (mode != "queue" && mode != "thread_local" && mode != "topology") return usage();
+
+    //   ".log"     (. resolveFileName  logs.cpp)
+    if (output.find(".log") == string::npos) output += ".log";
+
+    vector<ProfileEntry> profile;
+    if (!(inputs.size() == 1 && readProfile(inputs[0], profile)) && !readLogs(inputs, profile)) {
+        cerr << "    " << endl;
+        return 2;
+    }
+    if (!recordTo.empty()) {
+        if (!writeProfile(recordTo, profile)) {
+            cerr << "   " << recordTo << endl;
+            return 2;
+        }
+        cout << "profile: " << profile.size() << " entries -> " << recordTo << endl;
+        return 0;
+    }
+
+    vector<Event> events = expand(profile);
+    size_t maxSize = 0;
+    unsigned long long bytes = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].size > maxSize) maxSize = events[i].size;
+        bytes += events[i].size;
+    }
+    string payload(maxSize, 'x');
+    for (size_t i = 0; i < maxSize; i++) payload[i] = (char)('a' + i % 26);
+
+    remove(output.c_str());
+    Logs log;
+    log.setOutput(Logs::only_file);
+    log.setLevel(Logs::Severity::trace);
+    log.setAsync(true);
+    if (mode == "thread_local") log.setThreadLocal(true);
+    if (mode == "topology") log.setTopology(true);
+
+    vector<vector<unsigned> > latencies(threads);
+    vector<thread> workers;
+    clock_type::time_point start = clock_type::now() + chrono::milliseconds(10);
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&, t]() {
+            vector<unsigned>& lat = latencies[t];
+            lat.reserve(events.size() / threads + 1);
+            for (size_t i = (size_t)t; i < events.size(); i += (size_t)threads) {
+                const Event& e = events[i];
+                if (speed > 0) this_thread::sleep_until(start + chrono::nanoseconds((long long)(e.offsetNs / speed)));
+                string text(payload.data(), e.size);
+                clock_type::time_point begin = clock_type::now();
+                log.write((Logs::Severity)e.level, text, output);
+                long long ns = chrono::duration_cast<chrono::nanoseconds>(clock_type::now() - begin).count();
+                lat.push_back(ns > (long long)UINT_MAX ? UINT_MAX : (unsigned)ns);
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    log.flush();
+    double seconds = chrono::duration<double>(clock_type::now() - start).count();
+    log.setAsync(false);
+
+    vector<unsigned> all;
+    all.reserve(events.size());
+    for (int t = 0; t < threads; t++) all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+    sort(all.begin(), all.end());
+    unsigned long long lines = countLines(output);
+    remove(output.c_str());
+    struct rusage resources;
+    getrusage(RUSAGE_SELF, &resources);
+
+    Result r;
+    r.throughput = events.size() / seconds;
+    r.p50 = percentile(all, 0.50);
+    r.p99 = percentile(all, 0.99);
+    r.p999 = percentile(all, 0.999);
+    r.dropped = lines < events.size() ? (double)(events.size() - lines) : 0;
+    r.rssKb = (double)resources.ru_maxrss;
+
+    printf("records: %zu, threads: %d, mode: %s, speed: %g, time: %.2f s\n", events.size(), threads, mode.c_str(), speed, seconds);
+    printf("throughput: %.0f rec/s, %.1f MB/s\n", r.throughput, bytes / seconds / (1 << 20));
+    printf("latency ns: p50 %.0f, p99 %.0f, p999 %.0f, max %u\n", r.p50, r.p99, r.p999, all.empty() ? 0 : all.back());
+    printf("dropped: %.0f\n", r.dropped);
+    printf("peak rss: %.0f KB\n", r.rssKb);
+
+    if (!saveTo.empty() && !writeBaseline(saveTo, r)) {
+        cerr << "   " << saveTo << endl;
+        return 2;
+    }
+    if (baseline.empty()) return 0;
+    Result base = Result();
+    if (!readBaseline(baseline, base)) {
+        cerr << "    " << baseline << endl;
+        return 2;
+    }
+    printf("%-12s %14s %14s %10s\n", "metric", "current", "baseline", "change");
+    bool regression = false;
+    regression |= compare("throughput", r.throughput, base.throughput, tolerance, true);
+    regression |= compare("p50", r.p50, base.p50, tolerance, false);
+    regression |= compare("p99", r.p99, base.p99, tolerance, false);
+    regression |= compare("p999", r.p999, base.p999, tolerance, false);
+    regression |= compare("dropped", r.dropped, base.dropped, 0, false);
+    regression |= compare("rss_kb", r.rssKb, base.rssKb, tolerance, false);
+    return regression ? 1 : 0;
+}
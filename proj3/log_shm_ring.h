@@ -0,0 +1,474 @@
+#ifndef LOG_SHM_RING_H
+#define LOG_SHM_RING_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+using namespace std;
+
+/**      (shm_open/mmap)   .
+ *       (CAS   ),   -  -
+ *        .      ,
+ *      .       (seq):
+ *  seq ==       -     ,    ;
+ *  seq ==  + 1  -  ;
+ *  seq ==  + N  -      .
+ *        ,   recoveryTimeout
+ *   pid    ,    .
+ *     (heartbeat).     waitTimeout (  
+ * ,   ), publish()      false:  
+ *  ,            .   
+ *      waitTimeout -       dropped.
+ * :   fdatasync     (requestSync),  
+ *   fdatasync     (acknowledgeSync) -  fdatasync
+ *    .
+ *  POSIX  shm_open/mmap,  Windows -   (CreateFileMapping).
+ */
+class ShmLogRing {
+private:
+    static const uint64_t ring_magic = 0x4C4F4752494E4733ULL; // "LOGRING3"
+
+    /**  ;       */
+    struct Slot {
+        atomic<uint64_t> seq;
+        uint32_t count;         //    (  )
+        uint32_t length;        //     (  )
+        int32_t pid;            // - (  )
+        uint32_t reserved;
+    };
+
+    /**  ;       - */
+    struct Header {
+        atomic<uint64_t> magic;
+        uint64_t slots;
+        uint64_t slotSize;
+        char pad0[40];
+        atomic<uint64_t> enqueuePos;
+        char pad1[56];
+        atomic<uint64_t> dequeuePos;
+        char pad2[56];
+        atomic<uint64_t> published;
+        atomic<uint64_t> dropped;
+        atomic<uint64_t> recovered;
+        atomic<int64_t> heartbeat;  //   ,  steady_clock; 0 -  
+        atomic<uint64_t> syncRequest;   //  ,     fdatasync
+        atomic<uint64_t> syncedPos;     //        
+    };
+
+    string m_name;
+#ifdef _WIN32
+    HANDLE m_mapping;
+#endif
+    void* m_memory;
+    size_t m_mapSize;
+    Header* m_header;
+    char* m_slots;
+    uint64_t m_count;
+    uint64_t m_slotSize;
+    size_t m_payload;
+    chrono::milliseconds m_recoveryTimeout;
+    chrono::milliseconds m_waitTimeout;
+    bool m_owner;
+    uint64_t m_stuckPos;
+    chrono::steady_clock::time_point m_stuckSince;
+
+    Slot* slotAt(uint64_t pos) {
+        return (Slot*)(m_slots + (pos % m_count) * m_slotSize);
+    }
+
+    char* dataOf(Slot* slot) {
+        return (char*)slot + sizeof(Slot);
+    }
+
+    static bool processAlive(int pid) {
+        if (pid <= 0) return false;
+#ifdef _WIN32
+        HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+        if (process == NULL) return GetLastError() == ERROR_ACCESS_DENIED;
+        bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+        CloseHandle(process);
+        return alive;
+#else
+        return kill(pid, 0) == 0 || errno == EPERM;
+#endif
+    }
+
+    static int64_t nowMs() {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**     :  
+     * @param started -   (0 -   ,  )
+     * @return false,    :     waitTimeout
+     * (    )      waitTimeout
+    */
+    bool waitForReader(int64_t& started) {
+        int64_t now = nowMs();
+        if (started == 0) started = now;
+        int64_t limit = m_waitTimeout.count();
+        if (now - started >= limit || now - m_header->heartbeat.load(memory_order_relaxed) >= limit) return false;
+        this_thread::yield();
+        return true;
+    }
+
+    static int currentPid() {
+#ifdef _WIN32
+        return (int)GetCurrentProcessId();
+#else
+        return (int)getpid();
+#endif
+    }
+
+    /**    
+     * @param size -   ;      
+     * @param creator - true,     
+     * @return    0
+    */
+    void* mapRegion(size_t& size, bool& creator) {
+#ifdef _WIN32
+        string name = "Local\\" + (m_name[0] == '/' ? m_name.substr(1) : m_name);
+        m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            (DWORD)((unsigned long long)size >> 32), (DWORD)size, name.c_str());
+        if (m_mapping == NULL) return 0;
+        creator = GetLastError() != ERROR_ALREADY_EXISTS;
+        void* memory = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        if (memory == NULL) {
+            CloseHandle(m_mapping);
+            m_mapping = NULL;
+            return 0;
+        }
+        if (!creator) {
+            MEMORY_BASIC_INFORMATION info;
+            VirtualQuery(memory, &info, sizeof(info));
+            size = info.RegionSize;
+        }
+        return memory;
+#else
+        int fd = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+        if (fd >= 0) {
+            creator = true;
+            if (ftruncate(fd, (off_t)size) != 0) {
+                ::close(fd);
+                shm_unlink(m_name.c_str());
+                return 0;
+            }
+        }
+        else {
+            creator = false;
+            fd = shm_open(m_name.c_str(), O_RDWR, 0666);
+            if (fd < 0) return 0;
+            // ,    
+            struct stat st;
+            for (int i = 0; i < 1000; i++) {
+                if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header)) break;
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header)) {
+                ::close(fd);
+                return 0;
+            }
+            size = (size_t)st.st_size;
+        }
+        void* memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        return memory == MAP_FAILED ? 0 : memory;
+#endif
+    }
+
+    /**       */
+    void releaseSlots(uint64_t pos, uint64_t count) {
+        for (uint64_t i = 0; i < count; i++) {
+            Slot* s = slotAt(pos + i);
+            s->count = 0;
+            s->length = 0;
+            s->pid = 0;
+            s->seq.store(pos + i + m_count, memory_order_release);
+        }
+        m_header->dequeuePos.store(pos + count, memory_order_release);
+    }
+
+public:
+    ShmLogRing() :
+#ifdef _WIN32
+        m_mapping(NULL),
+#endif
+        m_memory(0), m_mapSize(0), m_header(0), m_slots(0), m_count(0), m_slotSize(0), m_payload(0),
+        m_recoveryTimeout(1000), m_waitTimeout(1000), m_owner(false), m_stuckPos(~0ULL) {}
+
+    ShmLogRing(const ShmLogRing&) = delete;
+    ShmLogRing& operator=(const ShmLogRing&) = delete;
+
+    ~ShmLogRing() {
+        close();
+    }
+
+    /**    (   )
+     * @param name -    ,  "/proj_logger"
+     * @param slots -  ,   2 (   ).  : 65536
+     * @param slotSize -    ,  64 (  ).  : 256
+     * @param owner - true - -:      close().  : false
+     * @return true,   
+    */
+    bool open(const string& name, size_t slots = 65536, size_t slotSize = 256, bool owner = false) {
+        close();
+        m_name = name;
+        slotSize = (slotSize < 128 ? 128 : slotSize + 63) / 64 * 64;
+        if (slots < 2) slots = 2;   //    "" (pos + 1)  "" (pos + N) 
+        size_t size = sizeof(Header) + slots * slotSize;
+        bool creator = false;
+        m_memory = mapRegion(size, creator);
+        if (m_memory == 0) return false;
+        m_mapSize = size;
+        m_header = (Header*)m_memory;
+        m_slots = (char*)m_memory + sizeof(Header);
+
+        if (creator) {
+            m_header->slots = slots;
+            m_header->slotSize = slotSize;
+            m_header->enqueuePos.store(0);
+            m_header->dequeuePos.store(0);
+            m_header->published.store(0);
+            m_header->dropped.store(0);
+            m_header->recovered.store(0);
+            m_header->heartbeat.store(0);
+            m_header->syncRequest.store(0);
+            m_header->syncedPos.store(0);
+            m_count = slots;
+            m_slotSize = slotSize;
+            for (uint64_t i = 0; i < m_count; i++) {
+                Slot* s = slotAt(i);
+                s->count = 0;
+                s->length = 0;
+                s->pid = 0;
+                s->seq.store(i, memory_order_relaxed);
+            }
+            m_header->magic.store(ring_magic, memory_order_release);
+        }
+        else {
+            for (int i = 0; i < 1000 && m_header->magic.load(memory_order_acquire) != ring_magic; i++) {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            if (m_header->magic.load(memory_order_acquire) != ring_magic) {
+                close();
+                return false;
+            }
+            m_count = m_header->slots;
+            m_slotSize = m_header->slotSize;
+        }
+        m_payload = m_slotSize - sizeof(Slot);
+        m_owner = owner;
+        if (owner) heartbeat();
+        return true;
+    }
+
+    /**   .  ()  ,    ,
+     *     :     
+    */
+    void close() {
+        if (m_header && m_owner) {
+            m_header->heartbeat.store(0, memory_order_relaxed);
+            unlink();
+        }
+        m_owner = false;
+#ifdef _WIN32
+        if (m_memory) UnmapViewOfFile(m_memory);
+        if (m_mapping) CloseHandle(m_mapping);
+        m_mapping = NULL;
+#else
+        if (m_memory) munmap(m_memory, m_mapSize);
+#endif
+        m_memory = 0;
+        m_header = 0;
+    }
+
+    /**     (     close()).
+     *  Windows   ,     .
+    */
+    void unlink() {
+#ifndef _WIN32
+        if (!m_name.empty()) shm_unlink(m_name.c_str());
+#endif
+    }
+
+    bool isOpen() const {
+        return m_header != 0;
+    }
+
+    /** ,        */
+    void setRecoveryTimeout(int ms) {
+        m_recoveryTimeout = chrono::milliseconds(ms);
+    }
+
+    /**        ,     
+     *  .  : 1000 
+    */
+    void setWaitTimeout(int ms) {
+        m_waitTimeout = chrono::milliseconds(ms);
+    }
+
+    /**  :      */
+    void heartbeat() {
+        if (m_header) m_header->heartbeat.store(nowMs(), memory_order_relaxed);
+    }
+
+    /** ,      waitTimeout  (0 -  ) */
+    bool readerAlive() const {
+        if (!m_header) return false;
+        int64_t beat = m_header->heartbeat.load(memory_order_relaxed);
+        return beat != 0 && nowMs() - beat < m_waitTimeout.count();
+    }
+
+    /**   (    )
+     * @param data -  
+     * @param len - ;     
+     * @param wait -     ,   ,    waitTimeout
+     * (      dropped)
+     * @param end -      ( requestSync).  : nullptr
+     * @return true,   ; false -      (. readerAlive)
+    */
+    bool publish(const char* data, size_t len, bool wait = true, uint64_t* end = nullptr) {
+        if (!readerAlive()) return false;
+        uint64_t count = len == 0 ? 1 : (len + m_payload - 1) / m_payload;
+        if (count > m_count) {
+            count = m_count;
+            len = count * m_payload;
+        }
+        uint64_t pos = m_header->enqueuePos.load(memory_order_relaxed);
+        int64_t waitStarted = 0;
+        while (true) {
+            uint64_t last = pos + count - 1;
+            uint64_t seq = slotAt(last)->seq.load(memory_order_acquire);
+            int64_t diff = (int64_t)(seq - last);
+            if (diff == 0) {
+                //     :   -  
+                if (m_header->enqueuePos.compare_exchange_weak(pos, pos + count, memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                if (!wait || !waitForReader(waitStarted)) {
+                    m_header->dropped.fetch_add(1, memory_order_relaxed);
+                    return false;
+                }
+                pos = m_header->enqueuePos.load(memory_order_relaxed);
+            }
+            else {
+                pos = m_header->enqueuePos.load(memory_order_relaxed);
+            }
+        }
+        Slot* first = slotAt(pos);
+        first->pid = (int32_t)currentPid();
+        first->count = (uint32_t)count;
+        first->length = (uint32_t)len;
+        for (uint64_t i = 0; i < count; i++) {
+            size_t n = len - i * m_payload < m_payload ? len - i * m_payload : m_payload;
+            memcpy(dataOf(slotAt(pos + i)), data + i * m_payload, n);
+        }
+        //     :     
+        for (uint64_t i = 1; i < count; i++) slotAt(pos + i)->seq.store(pos + i + 1, memory_order_release);
+        first->seq.store(pos + 1, memory_order_release);
+        m_header->published.fetch_add(1, memory_order_relaxed);
+        if (end) *end = pos + count;
+        return true;
+    }
+
+    /**  fdatasync    end () */
+    void requestSync(uint64_t end) {
+        if (!m_header) return;
+        uint64_t current = m_header->syncRequest.load(memory_order_relaxed);
+        while (current < end && !m_header->syncRequest.compare_exchange_weak(current, end, memory_order_release)) {}
+    }
+
+    /** ,       end */
+    bool synced(uint64_t end) const {
+        return m_header && m_header->syncedPos.load(memory_order_acquire) >= end;
+    }
+
+    /**  fdatasync    end ():  ,   
+     *   ,   fdatasync 
+     * @return true -  , false -   
+    */
+    bool waitSynced(uint64_t end) {
+        requestSync(end);
+        while (!synced(end)) {
+            if (!readerAlive()) return synced(end);
+            this_thread::sleep_for(chrono::microseconds(100));
+        }
+        return true;
+    }
+
+    /** ,   - fdatasync   () */
+    bool syncWanted() const {
+        return m_header && m_header->syncRequest.load(memory_order_acquire) > m_header->syncedPos.load(memory_order_relaxed);
+    }
+
+    /**  :       */
+    uint64_t readPosition() const {
+        return m_header ? m_header->dequeuePos.load(memory_order_relaxed) : 0;
+    }
+
+    /**  fdatasync    pos (,    fdatasync) */
+    void acknowledgeSync(uint64_t pos) {
+        if (m_header && m_header->syncedPos.load(memory_order_relaxed) < pos) m_header->syncedPos.store(pos, memory_order_release);
+    }
+
+    /**    (  -)
+     * @param out -    ()
+     * @return true,   
+    */
+    bool pop(string& out) {
+        if (!m_header) return false;
+        uint64_t pos = m_header->dequeuePos.load(memory_order_relaxed);
+        Slot* first = slotAt(pos);
+        uint64_t seq = first->seq.load(memory_order_acquire);
+        if (seq == pos + 1) {
+            uint64_t count = first->count;
+            size_t len = first->length;
+            out.resize(len);
+            for (uint64_t i = 0; i < count; i++) {
+                size_t n = len - i * m_payload < m_payload ? len - i * m_payload : m_payload;
+                memcpy(&out[i * m_payload], dataOf(slotAt(pos + i)), n);
+            }
+            releaseSlots(pos, count);
+            m_stuckPos = ~0ULL;
+            return true;
+        }
+        if (seq != pos || m_header->enqueuePos.load(memory_order_acquire) <= pos) return false;
+
+        //  ,   :     
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        if (m_stuckPos != pos) {
+            m_stuckPos = pos;
+            m_stuckSince = now;
+            return false;
+        }
+        if (now - m_stuckSince < m_recoveryTimeout) return false;
+        int pid = first->pid;
+        if (processAlive(pid)) return false;
+        //  :    (       -  )
+        uint64_t count = first->count ? first->count : 1;
+        releaseSlots(pos, count);
+        m_header->recovered.fetch_add(1, memory_order_relaxed);
+        m_stuckPos = ~0ULL;
+        return false;
+    }
+
+    /** : ,   ,    */
+    uint64_t published() const { return m_header ? m_header->published.load() : 0; }
+    uint64_t dropped() const { return m_header ? m_header->dropped.load() : 0; }
+    uint64_t recovered() const { return m_header ? m_header->recovered.load() : 0; }
+};
+
+#endif // LOG_SHM_RING_H
@@ -0,0 +1,72 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <cstddef>
+#include <string>
+
+/**   :        
+ * (, ,  ), . LogSink::writeParts
+ */
+struct LogSlice {
+    const char* data;
+    size_t len;
+};
+
+/**   (sink)   .
+ *      (. Logs::setAsync)
+ *         .
+ */
+class LogSink {
+public:
+    virtual ~LogSink() {}
+
+    /**    
+     * @param data -   
+     * @param len -    
+    */
+    virtual void write(const char* data, size_t len) = 0;
+
+    /**       ( ,   ,  syslog).
+     *    .
+     * @param level -   ( Logs::Severity: 0 - trace ... 4 - error)
+     * @param data -      
+     * @param len -    
+    */
+    virtual void writeRecord(int level, const char* data, size_t len) { (void)level; write(data, len); }
+
+    /**     .        write();
+     *        ,      .
+     * @param parts -    
+     * @param count -  
+    */
+    virtual void writeParts(const LogSlice* parts, size_t count) {
+        for (size_t i = 0; i < count; i++) write(parts[i].data, parts[i].len);
+    }
+
+    /**        .    
+     *   writeRecord():    (syslog, )   .
+    */
+    virtual void writeRecordParts(int level, const LogSlice* parts, size_t count) {
+        std::string record;
+        for (size_t i = 0; i < count; i++) record.append(parts[i].data, parts[i].len);
+        writeRecord(level, record.data(), record.size());
+    }
+
+    /**    (    ) */
+    virtual void flush() = 0;
+
+    /**       (fdatasync).   -  flush() */
+    virtual void sync() { flush(); }
+
+    /** ,   ,    flush() (,     ).
+     *   ,    flush(),    .  : false
+    */
+    virtual bool pending() const { return false; }
+
+    /**     :  async-signal-safe ,   .
+     * @return  ,     (   write(2)),  -1
+    */
+    virtual int emergencyFlush() { return -1; }
+};
+
+#endif // LOG_SINK_H
@@ -0,0 +1,164 @@
+#ifndef LOG_TOPOLOGY_H
+#define LOG_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+using namespace std;
+
+/**     :   ( NUMA),    ,
+ *       .  libnuma:   
+ * /sys/devices/system/node (Linux);       -     .
+ */
+class LogTopology {
+public:
+    /**   
+     * @param groups - 0 -   NUMA, N -    N   (,  -)
+    */
+    explicit LogTopology(int groups = 0) {
+        int cpus = (int)thread::hardware_concurrency();
+        if (cpus <= 0) cpus = 1;
+        if (groups <= 0) readNodes();
+        if (m_groups.empty()) {
+            int count = groups > 0 ? (groups < cpus ? groups : cpus) : 1;
+            m_groups.resize(count);
+            for (int cpu = 0; cpu < cpus; cpu++) m_groups[(size_t)cpu * count / cpus].push_back(cpu);
+        }
+        for (size_t g = 0; g < m_groups.size(); g++) {
+            for (size_t i = 0; i < m_groups[g].size(); i++) {
+                int cpu = m_groups[g][i];
+                if (cpu >= (int)m_groupOfCpu.size()) m_groupOfCpu.resize(cpu + 1, 0);
+                m_groupOfCpu[cpu] = (int)g;
+            }
+        }
+    }
+
+    /**   */
+    size_t size() const {
+        return m_groups.size();
+    }
+
+    /**   */
+    const vector<int>& cpus(size_t group) const {
+        return m_groups[group];
+    }
+
+    /**  ,      (0,   ) */
+    int currentGroup() const {
+        int cpu = currentCpu();
+        return cpu >= 0 && cpu < (int)m_groupOfCpu.size() ? m_groupOfCpu[cpu] : 0;
+    }
+
+    /**  ,    ; -1,    */
+    static int currentCpu() {
+#if defined(__linux__)
+        return sched_getcpu();
+#elif defined(_WIN32) && _WIN32_WINNT >= 0x0600
+        return (int)GetCurrentProcessorNumber();
+#else
+        return -1;
+#endif
+    }
+
+    /**     
+     * @param cpus -  ;  -   
+     * @return false,   
+    */
+    static bool pinCurrentThread(const vector<int>& cpus) {
+        if (cpus.empty()) return true;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (size_t i = 0; i < cpus.size(); i++) {
+            if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) CPU_SET(cpus[i], &set);
+        }
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for (size_t i = 0; i < cpus.size(); i++) {
+            if (cpus[i] >= 0 && cpus[i] < (int)(8 * sizeof(DWORD_PTR))) mask |= (DWORD_PTR)1 << cpus[i];
+        }
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+        return false;
+#endif
+    }
+
+    /**      nice: -20 () .. 19 (), 0 - .
+     *  Linux     (CAP_SYS_NICE).
+     * @return false,   
+    */
+    static bool setCurrentPriority(int nice) {
+#if defined(__linux__)
+        return setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) == 0;
+#elif defined(_WIN32)
+        int priority = nice <= -15 ? THREAD_PRIORITY_HIGHEST : nice < 0 ? THREAD_PRIORITY_ABOVE_NORMAL
+            : nice == 0 ? THREAD_PRIORITY_NORMAL : nice < 15 ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_LOWEST;
+        return SetThreadPriority(GetCurrentThread(), priority) != 0;
+#else
+        (void)nice;
+        return false;
+#endif
+    }
+
+    /**     "0-3,8,10-11" */
+    static vector<int> parseCpuList(const string& text) {
+        vector<int> cpus;
+        size_t i = 0;
+        while (i < text.size()) {
+            char* end;
+            long first = strtol(text.c_str() + i, &end, 10);
+            if (end == text.c_str() + i) break;
+            long last = first;
+            i = end - text.c_str();
+            if (i < text.size() && text[i] == '-') {
+                last = strtol(text.c_str() + i + 1, &end, 10);
+                i = end - text.c_str();
+            }
+            for (long cpu = first; cpu <= last; cpu++) cpus.push_back((int)cpu);
+            while (i < text.size() && (text[i] == ',' || text[i] == '\n' || text[i] == ' ')) i++;
+        }
+        return cpus;
+    }
+
+private:
+    vector<vector<int> > m_groups;
+    vector<int> m_groupOfCpu;
+
+    /**  NUMA  /sys/devices/system/node:    "online",    node<N>/cpulist.
+     *    ( ) .
+    */
+    void readNodes() {
+#ifdef __linux__
+        vector<int> nodes = parseCpuList(readLine("/sys/devices/system/node/online"));
+        for (size_t i = 0; i < nodes.size(); i++) {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[i]);
+            vector<int> cpus = parseCpuList(readLine(path));
+            if (!cpus.empty()) m_groups.push_back(cpus);
+        }
+#endif
+    }
+
+    static string readLine(const char* path) {
+        FILE* file = fopen(path, "r");
+        if (file == nullptr) return "";
+        char line[4096];
+        string text = fgets(line, sizeof(line), file) ? line : "";
+        fclose(file);
+        return text;
+    }
+};
+
+#endif // LOG_TOPOLOGY_H
@@ -0,0 +1,2545 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <queue>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include "logs.h"
+#include "log_encoding.h"
+#include "UsefulFunctions.h"
+#include "log_file_sink.h"
+#include "log_crash.h"
+#include "log_shm_ring.h"
+#include "log_compress.h"
+#include "log_clock.h"
+#include "log_index.h"
+#include "log_topology.h"
+using namespace std;
+
+/**  Logs:      .      Logs
+ *    (Logs   );       -
+ * ,   ,  Logs
+ */
+struct Logs::Impl {
+    /**     */
+    Output m_out;
+
+    /**    */
+    Severity m_level;
+
+    /**   */
+    static Logs* m_instance;
+
+    /**      */
+    static mutex m_mtx;
+
+    /** ,       (nullptr -  ) */
+    static thread_local const Impl* backendOwner;
+
+    Impl();
+    ~Impl();
+
+    void setAsync(bool async, size_t bufferSize = 1 << 20, int buffers = 4, bool datasync = false);
+    void setThreadLocal(bool enabled, size_t capacity);
+    void setLargePayload(size_t threshold);
+    void setTopology(bool enabled, int groups, const vector<int>& backendCpus, int priority);
+    bool setSharedRing(const string& name, bool drain, size_t slots, size_t slotSize);
+    void setFastTimestamps(bool enabled);
+    void setCompression(LogCompression codec, size_t blockSize, int level);
+    void setIndex(unsigned interval);
+    void setEncoding(LogEncoding from, LogEncoding to);
+    void setSampling(Severity level, double rate);
+    void setAdaptive(bool enabled, size_t highDepth, size_t lowDepth, int maxLatencyMs);
+    Stats getStats();
+    static string getCallSiteStats();
+    template <typename T>
+    void writeSampled(CallSite& site, Severity level, T& text);
+    void setMetrics(bool enabled, int intervalMs, const string& filename);
+    void writeMetric(MetricSite& site, long long value, bool hasValue);
+    void addSink(LogSink* sink, bool exclusive);
+    shared_ptr<Subscription> subscribe(const Filter& filter, size_t capacity);
+    void unsubscribe(const shared_ptr<Subscription>& subscription);
+    void installCrashHandler(const string& crashFile);
+    void flush();
+    void setDurability(Durability mode, int intervalMs);
+    void sync();
+    template <typename T>
+    void writeDurable(Severity level, T& text, string& filename, string& sourcefile, int sourceline);
+    template <typename T>
+    void writeDurableAsync(Severity level, T& text, string& filename, string& sourcefile, int sourceline);
+    void setFormat(string format);
+    void setFormat(const LogFormat& format);
+    void setFormat();
+    template <typename T>
+    void write(Severity level, T& text, string& filename, string& sourcefile, int sourceline);
+    template <typename T>
+    void writeConsole(Severity& level, T& text, string& sourcefile, int& sourceline);
+    template <typename T>
+    void writeFile(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline);
+    string getDatetime();
+    string getDatetime(time_t time_now);
+    string getDatetime(string format);
+    string getLevel(Severity& level);
+    template <typename T>
+    string getResultedString(Severity& level, T& text, string& sourcefile, int& sourceline, time_t when = time(0), 
+        const string* context = nullptr, size_t* messageAt = nullptr, const LogFormat* format = nullptr);
+
+    /**     ( )   :   /  
+     *    write()
+    */
+    template <typename T>
+    void output(Severity level, T& text, string& filename, string& sourcefile, int sourceline);
+
+    /**     :   "log_<>_<>.log", 
+     *      ".log"
+     * @param filename -  ,    (  )
+     * @return true,     
+    */
+    bool resolveFileName(string& filename);
+
+
+    /**        (atexit) */
+    static void shutdownInstance();
+
+    /**       ( -   ).
+     *    setFormat     m_formatMtx;  
+     *   ,          
+    */
+    shared_ptr<const LogFormat> m_format;
+    mutex m_formatMtx;
+
+    /** :      {ctx}.         */
+    atomic<bool> m_formatContext;
+
+    /**   (   m_formatMtx) */
+    shared_ptr<const LogFormat> currentFormat();
+
+    /** :     (   ) */
+    atomic<bool> m_async;
+
+    /** :      */
+    bool m_stop;
+
+    /** :    flush() */
+    unsigned long long m_flushRequests;
+
+    /** :     flush() */
+    unsigned long long m_flushDone;
+
+    /**     (. setAsync) */
+    size_t m_sinkBufferSize;
+    int m_sinkBuffers;
+    bool m_datasync;
+
+    /**   .        */
+    vector<Record> m_queue;
+
+    /**    */
+    mutex m_queueMtx;
+    condition_variable m_queueCv;
+    condition_variable m_flushCv;
+
+    /**     */
+    thread m_backend;
+
+    /**    :    ,      */
+    struct OpenFile {
+        LogSink* sink;
+        chrono::steady_clock::time_point used;
+    };
+
+    /**    :   ->  (   ) */
+    map<string, OpenFile> m_fileSinks;
+
+    /**          */
+    static const int sink_idle_seconds = 30;
+
+    /**     :     ,      */
+    string m_defaultFile;
+
+    /**       (  ) */
+    chrono::steady_clock::time_point m_batchTime;
+
+    /**    (. addSink) */
+    vector<LogSink*> m_sinks;
+
+    /**   (. subscribe) */
+    vector<shared_ptr<Subscription> > m_subscriptions;
+
+    /**   -    m_batch (  ).
+     *     ; ,    ,    .
+    */
+    void collectMetrics(const string& filename, double seconds);
+
+    /** :      */
+    bool m_sinksOnly;
+
+    /**  ,   ,         .
+     *   ,    ,    .
+    */
+    vector<Record> m_batch;
+    volatile size_t m_batchPos;
+
+    /** :    (   ) */
+    LogSink* volatile m_lastSink;
+
+    /**       */
+    enum BackendState {backend_running, backend_waiting, backend_parked};
+
+    /** :    -     */
+    atomic<int> m_crashing;
+
+    /**     (BackendState) */
+    atomic<int> m_backendState;
+
+    /**        (   ) */
+    void parkForCrash();
+
+    /**     (. setSharedRing);      */
+    atomic<ShmLogRing*> m_sharedRing;
+
+    /** :         */
+    bool m_sharedDrain;
+
+    /**   :  ,    ( steady_clock)
+     *   .       :    
+     *       (publish     false)
+    */
+    string m_sharedName;
+    size_t m_sharedSlots;
+    size_t m_sharedSlotSize;
+    atomic<long long> m_nextReconnect;
+    vector<ShmLogRing*> m_retiredRings;
+    mutex m_ringMtx;
+
+    /**         ,    */
+    static const int reconnect_ms = 100;
+
+    /**        :    ,
+     *    .       reconnect_ms
+     * @param ring - ,    
+     * @return       nullptr
+    */
+    ShmLogRing* reconnectSharedRing(ShmLogRing* ring);
+
+    /**   (. setEncoding) */
+    LogEncoding m_encodingFrom;
+    LogEncoding m_encodingTo;
+
+    /**   (   ) */
+    LogTranscoder m_transcoder;
+
+    /**      (   ) */
+    string m_sharedRecord;
+
+    /**    (. setMetrics) */
+    atomic<bool> m_metrics;
+    chrono::steady_clock::duration m_metricsInterval;
+    chrono::steady_clock::time_point m_nextMetrics;
+    chrono::steady_clock::time_point m_lastMetrics;
+    string m_metricsFile;
+
+    /**     (. setFastTimestamps); m_clock       */
+    atomic<bool> m_fastTime;
+    LogClock* m_clock;
+    chrono::steady_clock::time_point m_nextCalibration;
+
+    /**    :      */
+    void stampRecord(Record& r);
+
+    /**        (  ) */
+    void resolveTime(Record& r);
+
+    /**    (. setCompression) */
+    LogCompression m_compression;
+    size_t m_compressionBlock;
+    int m_compressionLevel;
+
+    /**   (. setDurability, sync); m_nextInlineSync -   fdatasync
+     *     periodic ( steady_clock)
+    */
+    atomic<Durability> m_durability;
+    chrono::steady_clock::duration m_syncInterval;
+    atomic<long long> m_nextInlineSync;
+    unsigned long long m_syncRequests;
+    unsigned long long m_syncDone;
+    atomic<unsigned long long> m_syncCount;
+
+    /**  :   flush ( sync,  durable)   .
+     *  durable          (. m_sharedDurable)
+    */
+    struct PendingCompletion {
+        unsigned long long request;
+        bool durable;
+        unsigned long long sharedSerial;
+        function<void()> done;
+    };
+
+    /**    (. Completion) */
+    vector<PendingCompletion> m_completions;
+
+    /** fdatasync       (. setDurability) */
+    void syncWritten(Severity level, const string& filename);
+
+    /**        flush  sync
+     * @return false,     ( , done  )
+    */
+    bool addCompletion(bool durable, function<void()> done);
+
+    /**      ( , lock    ) */
+    void runCompletions(unique_lock<mutex>& lock);
+
+    /**      :   fdatasync ( )
+     *   -  fdatasync    
+    */
+    struct InlineSync {
+        int fd;
+        unsigned long long started;
+        unsigned long long done;
+        bool running;
+        bool ok;
+        int users;
+    };
+
+    /**     :   ->  ( m_inlineSyncMtx) */
+    map<string, InlineSync> m_inlineSyncs;
+    mutex m_inlineSyncMtx;
+    condition_variable m_inlineSyncCv;
+
+    /**      ,     */
+    static const size_t inline_sync_files = 16;
+
+    /** fdatasync   : ,  ,    fdatasync.
+     *  fdatasync,     ;  ,   ,  
+     *  ,    
+     * @return true,   
+    */
+    bool syncFile(const string& filename);
+
+    /**    ,    : ,   
+     *  fdatasync  end;    ,     
+    */
+    struct SharedDurable {
+        ShmLogRing* ring;
+        uint64_t end;
+        unsigned long long serial;
+        string record;
+    };
+
+    /**      ( m_sharedDurableMtx,  
+     *       -        ,   )
+    */
+    vector<SharedDurable> m_sharedDurable;
+    atomic<unsigned long long> m_sharedDurableSerial;
+    mutex m_sharedDurableMtx;
+
+    /**  ,     ( m_queueMtx):    
+     *  ,         
+    */
+    unsigned long long m_sharedWanted;
+    unsigned long long m_sharedSettled;
+
+    /**       (writeDurable): publishShared  
+     *  m_sharedDurable      
+    */
+    struct DurableMark {
+        bool active;
+        ShmLogRing* ring;
+        uint64_t end;
+    };
+    static thread_local DurableMark durableMark;
+
+    /**     :  ,  
+     *        fdatasync
+     * @return ,       
+    */
+    unsigned long long settleSharedDurable();
+
+    /**   ,       (. durableMark) */
+    void waitSharedDurable();
+
+    /**       (. setIndex); 0 -   */
+    unsigned m_indexInterval;
+
+    /**    :   ->  (   ) */
+    map<string, LogIndexWriter*> m_indexes;
+
+    /**       (      ) */
+    void indexRecord(const string& filename, int level, chrono::system_clock::time_point time, size_t length);
+
+    /**     : ",   (8 ,   ),  \0 
+     *   ".       
+     * @return false,         
+    */
+    template <typename T>
+    bool publishShared(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline);
+
+    /**    ,      (  )
+     * @return  
+    */
+    size_t drainSharedRing(vector<LogSink*>& sinks, bool sinksOnly, vector<shared_ptr<Subscription> >& subscriptions);
+
+    /**     :       */
+    void publishSharedRecord(int level, chrono::system_clock::time_point time, size_t split, vector<shared_ptr<Subscription> >& subscriptions);
+
+    /**      (. ) */
+    struct ThreadBuffer;
+
+    /** :      (. setThreadLocal) */
+    atomic<bool> m_threadLocal;
+
+    /**      */
+    size_t m_threadBufferSize;
+
+    /** :       ,  ,  ,   */
+    atomic<bool> m_backendSleeping;
+
+    /**        (   -  m_queueMtx) */
+    condition_variable m_spaceCv;
+    int m_spaceWaiters;
+
+    /** :  setAsync(false)       */
+    mutex m_stopMtx;
+
+    /**    , :    ,       */
+    static const int merge_window_ms = 2;
+
+    /**    flush()    ,  */
+    static const int pending_retry_ms = 5;
+
+    /**     (. setLargePayload); 0 -  */
+    atomic<size_t> m_largePayload;
+
+    /**      .   ( write() -  
+     * )  , LogPayload -  ,    text
+    */
+    void takeText(Record& r, string& text);
+    void takeText(Record& r, LogPayload& text);
+    template <typename T>
+    void takeText(Record& r, T& text);
+
+    /**      (   m_queueMtx) */
+    vector<ThreadBuffer*> m_threadBuffers;
+
+    /**    :    (  , m_orderBuffer -  ),
+     *   m_batch (m_orderBuffer - nullptr)
+    */
+    vector<Record*> m_order;
+    vector<ThreadBuffer*> m_orderBuffer;
+
+    /**    :       (   ) */
+    unsigned long long m_serial;
+
+    static unsigned long long nextSerial();
+
+    /**        (     ) */
+    ThreadBuffer* getThreadBuffer();
+
+    /**     .    - ,     .
+     *     (     ),   
+    */
+    template <typename T>
+    void enqueueThreadLocal(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline, bool defaultFile);
+
+    /**       ( :     m_spaceCv)
+     * @param tail -   
+    */
+    void waitForSpace(ThreadBuffer* b, size_t tail);
+
+    /**   ,         .
+     *   setAsync(false),          
+    */
+    void writeStopped(ThreadBuffer* b);
+
+    /**   ,   ,    */
+    void wakeBackend();
+
+    /**   setAsync(false)   :   
+     *  ,        
+    */
+    void waitForStop();
+
+    /**        (   ) */
+    void writeRecordNow(Record& r);
+
+    /**        m_order (   ).
+     * @param buffers -  
+     * @param all -   (flush/),      
+    */
+    void collectThreadBuffers(vector<ThreadBuffer*>& buffers, bool all);
+
+    /**    ,     */
+    void releaseClosedBuffers();
+
+    /**      (. ) */
+    struct NodeQueue;
+
+    /** :       (. setTopology) */
+    atomic<bool> m_topologyMode;
+
+    /**    (    setTopology) */
+    LogTopology* m_topology;
+
+    /**   :    ,    m_topology       */
+    vector<NodeQueue*> m_nodeQueues;
+
+    /**      ; m_backendSettings     */
+    vector<int> m_backendCpus;
+    int m_backendPriority;
+    unsigned m_backendSettings;
+
+    /**          m_batch (  ) */
+    void collectNodeQueues(vector<NodeQueue*>& queues);
+
+    /**       32-   (2^32 -  ) */
+    static unsigned long long rateToThreshold(double rate);
+
+    /**      (xorshift64*),    */
+    static unsigned nextRandom();
+
+    /**    */
+    enum CounterKind {counter_accepted, counter_sampled, counter_shed};
+
+    /**     (. ) */
+    struct ThreadCounters;
+
+    /**      (   m_countersMtx) */
+    vector<ThreadCounters*> m_threadCounters;
+
+    /**     (  m_countersMtx) */
+    unsigned long long m_retiredCounters[3][level_count];
+    mutex m_countersMtx;
+
+    /**      (  nextRandom) */
+    atomic<unsigned long long> m_sampleThreshold[level_count];
+
+    /**    */
+    atomic<bool> m_adaptive;
+    atomic<int> m_adaptiveLevel;
+    size_t m_highDepth;
+    size_t m_lowDepth;
+    int m_maxLatencyMs;
+    chrono::steady_clock::time_point m_adaptiveChanged;
+    atomic<unsigned long long> m_levelRaises;
+    atomic<unsigned long long> m_levelRestores;
+    atomic<size_t> m_maxQueueDepth;
+
+    /**    -    */
+    static int counterShard();
+
+    /**        (     ) */
+    ThreadCounters* threadCounters();
+
+    /**      m_retiredCounters ( m_countersMtx) */
+    void foldClosedCounters();
+
+    /**        */
+    void countDecision(CounterKind kind, Severity level);
+
+    /**    :  ,    
+     * @return true,    
+    */
+    bool accept(Severity level);
+
+    /**        (  )
+     * @param depth -   (    )
+     * @param latency -   
+    */
+    void adaptLevel(size_t depth, chrono::steady_clock::duration latency);
+
+    /**     LOG_SAMPLED */
+    static vector<CallSite*>& callSites();
+
+    /**     LOG_METRIC (  callSitesMutex) */
+    static vector<MetricSite*>& metricSites();
+
+    static mutex& callSitesMutex();
+
+    /**     LogCrashHandler */
+    static void crashDrain(void* ctx, const char* crash, void** frames, int nframes);
+
+    /**   (   ,     ).
+     *    :    ,   .
+     *       ,  m_format.
+    */
+    void emergencyDrain(const char* crash, void** frames, int nframes);
+
+    /**            */
+    void emergencyRecord(CrashWriter& w, Record& r);
+
+    /**      
+     * @param defaultFile - filename -    (. resolveFileName)
+     * @return false,          
+    */
+    template <typename T>
+    bool enqueue(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline, bool defaultFile);
+
+    /**       (   ) */
+    LogSink* getFileSink(const string& filename);
+
+    /**     :      
+     * @param unsynced -     fdatasync (  )
+    */
+    LogSink* getDefaultSink(const string& filename, bool unsynced);
+
+    /**        */
+    void closeFileSink(map<string, OpenFile>::iterator it, bool unsynced);
+
+    /**  ,      sink_idle_seconds */
+    void closeIdleSinks(bool unsynced);
+
+    /**      
+     * @return true,        (. LogSink::pending)
+    */
+    bool flushSinks(vector<LogSink*>& sinks);
+
+    /**     fdatasync (      )
+     * @return true,       
+    */
+    bool syncSinks(vector<LogSink*>& sinks);
+
+    /** ,           */
+    bool hasThreadRecords();
+
+    /**   :   ,     .
+     *     ,   ,  flush()   .
+    */
+    void backendLoop();
+};
+
+//   
+Logs* Logs::Impl::m_instance = nullptr;
+mutex Logs::Impl::m_mtx;
+thread_local const Logs::Impl* Logs::Impl::backendOwner = nullptr;
+thread_local Logs::Impl::DurableMark Logs::Impl::durableMark = {false, nullptr, 0};
+
+/**        :     */
+static const size_t shared_prefix = 1 + sizeof(long long);
+
+/**     :   (-),   ( ).
+ *       ,    -- .
+ *   ,     :    .
+*/
+struct Logs::Impl::ThreadBuffer {
+    vector<Record> slots;
+    char pad0[64];
+    atomic<size_t> head;        //    
+    char pad1[64];
+    atomic<size_t> tail;        //   -
+    size_t cachedHead;          //  head  :  -    
+    char pad2[64];
+    atomic<bool> closed;        // - 
+    atomic<int> refs;
+
+    explicit ThreadBuffer(size_t capacity) : slots(capacity), head(0), tail(0), cachedHead(0), closed(false), refs(2) {}
+
+    void release() {
+        if (--refs == 0) delete this;
+    }
+};
+
+/**     :   - ( 
+ *  ,  lock-), getStats    .  ,     .
+*/
+struct Logs::Impl::ThreadCounters {
+    atomic<unsigned long long> values[3][level_count];
+    atomic<bool> closed;        // - ,     
+    atomic<int> refs;
+
+    ThreadCounters() : closed(false), refs(2) {
+        for (int k = 0; k < 3; k++) {
+            for (int i = 0; i < level_count; i++) values[k][i] = 0;
+        }
+    }
+
+    void add(int kind, int level) {
+        atomic<unsigned long long>& value = values[kind][level];
+        value.store(value.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+
+    void release() {
+        if (--refs == 0) delete this;
+    }
+};
+
+/**    :     mtx,    records
+ *   spare.      ,   ,
+ *           .
+*/
+struct Logs::Impl::NodeQueue {
+    char pad0[64];
+    mutex mtx;
+    vector<Record> records;
+    vector<Record> spare;       //    
+    char pad1[64];
+};
+
+Logs::Impl::Impl() : m_format(make_shared<const LogFormat>()), m_formatContext(false), m_async(false), m_stop(false), m_flushRequests(0), m_flushDone(0),
+    m_sinkBufferSize(1 << 20), m_sinkBuffers(4), m_datasync(false), m_sinksOnly(false), m_batchPos(0), m_lastSink(nullptr), 
+    m_crashing(0), m_backendState(backend_running), m_sharedRing(nullptr), m_sharedDrain(false), m_sharedSlots(0), m_sharedSlotSize(0), m_nextReconnect(0), 
+    m_encodingFrom(LogEncoding::none), m_encodingTo(LogEncoding::none), m_metrics(false), m_metricsInterval(chrono::seconds(10)), 
+    m_fastTime(false), m_clock(nullptr), 
+    m_compression(LogCompression::none), m_compressionBlock(1 << 20), m_compressionLevel(1), 
+    m_durability(Durability::none), m_syncInterval(chrono::milliseconds(100)), m_nextInlineSync(0), m_syncRequests(0), m_syncDone(0), m_syncCount(0), m_sharedDurableSerial(0), m_sharedWanted(0), m_sharedSettled(0), m_indexInterval(0), m_threadLocal(false), m_threadBufferSize(8192), m_backendSleeping(false), m_spaceWaiters(0), m_largePayload(0), m_serial(nextSerial()),
+    m_topologyMode(false), m_topology(nullptr), m_backendPriority(0), m_backendSettings(0),
+    m_adaptive(false), m_adaptiveLevel(0), m_highDepth(0), m_lowDepth(0), m_maxLatencyMs(0), 
+    m_levelRaises(0), m_levelRestores(0), m_maxQueueDepth(0) {
+    for (int i = 0; i < level_count; i++) m_sampleThreshold[i] = rateToThreshold(1.0);
+    for (int k = 0; k < 3; k++) {
+        for (int i = 0; i < level_count; i++) m_retiredCounters[k][i] = 0;
+    }
+}
+
+Logs::Impl::~Impl() {
+    LogCrashHandler::removeDrain(this);
+    setAsync(false);
+    delete m_sharedRing.load();
+    for (size_t i = 0; i < m_retiredRings.size(); i++) delete m_retiredRings[i];
+    for (map<string, InlineSync>::iterator it = m_inlineSyncs.begin(); it != m_inlineSyncs.end(); ++it) {
+        if (it->second.fd >= 0) FileSink::closeDescriptor(it->second.fd);
+    }
+    delete m_clock;
+    for (size_t i = 0; i < m_sinks.size(); i++) delete m_sinks[i];
+    for (size_t i = 0; i < m_threadBuffers.size(); i++) m_threadBuffers[i]->release();
+    for (size_t i = 0; i < m_nodeQueues.size(); i++) delete m_nodeQueues[i];
+    for (size_t i = 0; i < m_threadCounters.size(); i++) m_threadCounters[i]->release();
+    delete m_topology;
+}
+
+void Logs::Impl::shutdownInstance() {
+    //   :         ( )
+    m_instance->setAsync(false);
+}
+
+void Logs::Impl::setAsync(bool async, size_t bufferSize, int buffers, bool datasync) {
+    //    m_stopMtx: ,  ,    (. writeStopped)
+    unique_lock<mutex> stopLock(m_stopMtx, defer_lock);
+    if (!async) stopLock.lock();
+    unique_lock<mutex> lock(m_queueMtx);
+    if (async) {
+        m_sinkBufferSize = bufferSize;
+        m_sinkBuffers = buffers;
+        m_datasync = datasync;
+        if (m_async) return;
+        m_stop = false;
+        m_async = true;
+        m_backend = thread(&Impl::backendLoop, this);
+        return;
+    }
+    if (!m_async) return;
+    m_async = false;
+    m_stop = true;
+    m_queueCv.notify_all();
+    m_spaceCv.notify_all();
+    lock.unlock();
+    m_backend.join();
+    m_flushCv.notify_all();
+    m_lastSink = nullptr;
+    for (map<string, OpenFile>::iterator it = m_fileSinks.begin(); it != m_fileSinks.end(); ++it) {
+        delete it->second.sink;
+    }
+    m_fileSinks.clear();
+    m_defaultFile.clear();
+    for (map<string, LogIndexWriter*>::iterator it = m_indexes.begin(); it != m_indexes.end(); ++it) {
+        delete it->second;
+    }
+    m_indexes.clear();
+}
+
+void Logs::Impl::setThreadLocal(bool enabled, size_t capacity) {
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        m_threadBufferSize = capacity ? capacity : 1;
+        m_threadLocal = enabled;
+    }
+    if (enabled) setAsync(true, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+}
+
+void Logs::Impl::setTopology(bool enabled, int groups, const vector<int>& backendCpus, int priority) {
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        if (enabled && m_topology == nullptr) {
+            m_topology = new LogTopology(groups);
+            for (size_t g = 0; g < m_topology->size(); g++) {
+                NodeQueue* queue = nullptr;
+                const vector<int>& cpus = m_topology->cpus(g);
+                //       -    
+                thread([&queue, &cpus]() {
+                    LogTopology::pinCurrentThread(cpus);
+                    queue = new NodeQueue();
+                    queue->records.resize(4096);
+                    queue->records.clear();
+                    queue->spare.resize(4096);
+                    queue->spare.clear();
+                }).join();
+                m_nodeQueues.push_back(queue);
+            }
+        }
+        m_backendCpus = backendCpus;
+        m_backendPriority = priority;
+        m_backendSettings++;
+        m_topologyMode = enabled;
+    }
+    if (enabled) setAsync(true, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+}
+
+void Logs::Impl::setLargePayload(size_t threshold) {
+    m_largePayload = threshold;
+}
+
+bool Logs::Impl::setSharedRing(const string& name, bool drain, size_t slots, size_t slotSize) {
+    {
+        //   open(): ,  ,        
+        lock_guard<mutex> ringLock(m_ringMtx);
+        if (m_sharedRing.load()) return false;
+        ShmLogRing* ring = new ShmLogRing();
+        if (!ring->open(name, slots, slotSize, drain)) {
+            delete ring;
+            return false;
+        }
+        m_sharedName = name;
+        m_sharedSlots = slots;
+        m_sharedSlotSize = slotSize;
+        lock_guard<mutex> lock(m_queueMtx);
+        m_sharedDrain = drain;
+        m_sharedRing.store(ring, memory_order_release);
+    }
+    if (drain) setAsync(true, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+    return true;
+}
+
+ShmLogRing* Logs::Impl::reconnectSharedRing(ShmLogRing* ring) {
+    if (m_sharedDrain) return nullptr;
+    long long now = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    if (now < m_nextReconnect.load(memory_order_relaxed)) return nullptr;
+    unique_lock<mutex> lock(m_ringMtx, try_to_lock);
+    if (!lock.owns_lock()) return nullptr;
+    ShmLogRing* current = m_sharedRing.load(memory_order_acquire);
+    if (current != ring) return current->readerAlive() ? current : nullptr;
+    m_nextReconnect.store(now + reconnect_ms, memory_order_relaxed);
+    ShmLogRing* fresh = new ShmLogRing();
+    if (!fresh->open(m_sharedName, m_sharedSlots, m_sharedSlotSize) || !fresh->readerAlive()) {
+        delete fresh;
+        return nullptr;
+    }
+    m_retiredRings.push_back(ring);
+    m_sharedRing.store(fresh, memory_order_release);
+    return fresh;
+}
+
+void Logs::Impl::setFastTimestamps(bool enabled) {
+    lock_guard<mutex> lock(m_queueMtx);
+    if (enabled && m_clock == nullptr) {
+        m_clock = new LogClock();
+        m_nextCalibration = chrono::steady_clock::now() + chrono::seconds(1);
+    }
+    m_fastTime = enabled;
+}
+
+void Logs::Impl::setCompression(LogCompression codec, size_t blockSize, int level) {
+    lock_guard<mutex> lock(m_queueMtx);
+    m_compression = codec;
+    m_compressionBlock = blockSize;
+    m_compressionLevel = level;
+}
+
+void Logs::Impl::setIndex(unsigned interval) {
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        m_indexInterval = interval;
+    }
+    if (interval) setAsync(true, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+}
+
+void Logs::Impl::setEncoding(LogEncoding from, LogEncoding to) {
+    lock_guard<mutex> lock(m_queueMtx);
+    m_encodingFrom = from;
+    m_encodingTo = to;
+}
+
+void Logs::Impl::setSampling(Severity level, double rate) {
+    m_sampleThreshold[(int)level] = rateToThreshold(rate);
+}
+
+void Logs::Impl::setAdaptive(bool enabled, size_t highDepth, size_t lowDepth, int maxLatencyMs) {
+    lock_guard<mutex> lock(m_queueMtx);
+    m_highDepth = highDepth;
+    m_lowDepth = lowDepth;
+    m_maxLatencyMs = maxLatencyMs;
+    m_adaptive = enabled;
+    if (!enabled) m_adaptiveLevel = 0;
+}
+
+Logs::Stats Logs::Impl::getStats() {
+    Stats st;
+    {
+        lock_guard<mutex> lock(m_countersMtx);
+        foldClosedCounters();
+        for (int i = 0; i < level_count; i++) {
+            st.accepted[i] = m_retiredCounters[counter_accepted][i];
+            st.sampledOut[i] = m_retiredCounters[counter_sampled][i];
+            st.shed[i] = m_retiredCounters[counter_shed][i];
+            for (size_t t = 0; t < m_threadCounters.size(); t++) {
+                ThreadCounters* c = m_threadCounters[t];
+                st.accepted[i] += c->values[counter_accepted][i].load(memory_order_relaxed);
+                st.sampledOut[i] += c->values[counter_sampled][i].load(memory_order_relaxed);
+                st.shed[i] += c->values[counter_shed][i].load(memory_order_relaxed);
+            }
+        }
+    }
+    st.levelRaises = m_levelRaises;
+    st.levelRestores = m_levelRestores;
+    int effective = m_adaptiveLevel > (int)m_level ? (int)m_adaptiveLevel : (int)m_level;
+    st.effectiveLevel = (Severity)effective;
+    st.maxQueueDepth = m_maxQueueDepth;
+    st.syncs = m_syncCount;
+    return st;
+}
+
+string Logs::Impl::getCallSiteStats() {
+    string result;
+    lock_guard<mutex> lock(callSitesMutex());
+    vector<CallSite*>& sites = callSites();
+    for (size_t i = 0; i < sites.size(); i++) {
+        result += string(sites[i]->file) + ":" + to_string(sites[i]->line) + " kept=" + to_string(sites[i]->kept.load()) + 
+            " dropped=" + to_string(sites[i]->dropped.load()) + "\n";
+    }
+    return result;
+}
+
+template <typename T>
+void Logs::Impl::writeSampled(CallSite& site, Severity level, T& text) {
+    if (level < m_level) return;
+    if (site.threshold <= 0xFFFFFFFFULL && nextRandom() >= site.threshold) {
+        site.dropped.fetch_add(1, memory_order_relaxed);
+        countDecision(counter_sampled, level);
+        return;
+    }
+    //           
+    if (!accept(level)) {
+        site.dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    site.kept.fetch_add(1, memory_order_relaxed);
+    string filename, sourcefile;
+    output(level, text, filename, sourcefile, -1);
+}
+
+void Logs::Impl::setMetrics(bool enabled, int intervalMs, const string& filename) {
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        m_metricsInterval = chrono::milliseconds(intervalMs > 0 ? intervalMs : 1);
+        m_metricsFile = filename;
+        m_lastMetrics = chrono::steady_clock::now();
+        m_nextMetrics = m_lastMetrics + m_metricsInterval;
+        m_metrics = enabled;
+    }
+    if (enabled) setAsync(true, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+}
+
+void Logs::Impl::writeMetric(MetricSite& site, long long value, bool hasValue) {
+    if (site.level < m_level) return;
+    if (m_metrics) {
+        site.add(value, hasValue);
+        return;
+    }
+    string filename, sourcefile;
+    if (hasValue) {
+        string text = string(site.message) + " " + to_string(value);
+        write(site.level, text, filename, sourcefile, -1);
+    }
+    else write(site.level, site.message, filename, sourcefile, -1);
+}
+
+void Logs::Impl::addSink(LogSink* sink, bool exclusive) {
+    lock_guard<mutex> lock(m_queueMtx);
+    m_sinks.push_back(sink);
+    if (exclusive) m_sinksOnly = true;
+}
+
+shared_ptr<Logs::Subscription> Logs::Impl::subscribe(const Filter& filter, size_t capacity) {
+    Filter resolved = filter;
+    if (!resolved.category.empty()) resolveFileName(resolved.category);
+    shared_ptr<Subscription> subscription(new Subscription(resolved, capacity));
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        m_subscriptions.push_back(subscription);
+    }
+    setAsync(true, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+    return subscription;
+}
+
+void Logs::Impl::unsubscribe(const shared_ptr<Subscription>& subscription) {
+    lock_guard<mutex> lock(m_queueMtx);
+    for (size_t i = 0; i < m_subscriptions.size(); i++) {
+        if (m_subscriptions[i] == subscription) {
+            m_subscriptions.erase(m_subscriptions.begin() + i);
+            break;
+        }
+    }
+}
+
+void Logs::Impl::installCrashHandler(const string& crashFile) {
+    LogCrashHandler::install(crashFile.c_str());
+    LogCrashHandler::removeDrain(this);
+    LogCrashHandler::addDrain(&Impl::crashDrain, this);
+}
+
+void Logs::Impl::flush() {
+    unique_lock<mutex> lock(m_queueMtx);
+    if (!m_async) return;
+    unsigned long long request = ++m_flushRequests;
+    m_queueCv.notify_all();
+    while (m_async && m_flushDone < request) m_flushCv.wait(lock);
+}
+
+void Logs::Impl::setDurability(Durability mode, int intervalMs) {
+    lock_guard<mutex> lock(m_queueMtx);
+    m_syncInterval = chrono::milliseconds(intervalMs > 0 ? intervalMs : 1);
+    m_durability = mode;
+}
+
+void Logs::Impl::sync() {
+    unique_lock<mutex> lock(m_queueMtx);
+    if (!m_async) return;
+    unsigned long long request = ++m_syncRequests;
+    m_queueCv.notify_all();
+    while (m_async && m_syncDone < request) m_flushCv.wait(lock);
+}
+
+template <typename T>
+void Logs::Impl::writeDurable(Severity level, T& text, string& filename, string& sourcefile, int sourceline) {
+    resolveFileName(filename);
+    durableMark.active = true;
+    durableMark.ring = nullptr;
+    write(level, text, filename, sourcefile, sourceline);
+    durableMark.active = false;
+    //     :     ,   
+    if (durableMark.ring) waitSharedDurable();
+    else if (m_async) sync();
+    else if (m_out != only_console) syncFile(filename);
+}
+
+template <typename T>
+void Logs::Impl::writeDurableAsync(Severity level, T& text, string& filename, string& sourcefile, int sourceline) {
+    resolveFileName(filename);
+    durableMark.active = true;
+    durableMark.ring = nullptr;
+    write(level, text, filename, sourcefile, sourceline);
+    durableMark.active = false;
+    //        (. settleSharedDurable)
+    if (durableMark.ring) setAsync(true, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+    //       ,  Completion  
+    else if (!m_async && m_out != only_console) syncFile(filename);
+}
+
+bool Logs::Impl::syncFile(const string& filename) {
+    unique_lock<mutex> lock(m_inlineSyncMtx);
+    map<string, InlineSync>::iterator it = m_inlineSyncs.find(filename);
+    if (it == m_inlineSyncs.end()) {
+        //       :   
+        if (m_inlineSyncs.size() >= inline_sync_files) {
+            for (map<string, InlineSync>::iterator i = m_inlineSyncs.begin(); i != m_inlineSyncs.end();) {
+                if (i->second.users > 0) {
+                    ++i;
+                    continue;
+                }
+                if (i->second.fd >= 0) FileSink::closeDescriptor(i->second.fd);
+                m_inlineSyncs.erase(i++);
+            }
+        }
+        InlineSync created = {-1, 0, 0, false, false, 0};
+        it = m_inlineSyncs.insert(make_pair(filename, created)).first;
+    }
+    InlineSync& f = it->second;
+    f.users++;
+    //  fdatasync      -  
+    unsigned long long target = f.started + 1;
+    while (f.done < target) {
+        if (f.running) {
+            m_inlineSyncCv.wait(lock);
+            continue;
+        }
+        f.running = true;
+        f.started++;
+        int fd = f.fd;
+        lock.unlock();
+        if (fd >= 0 && !FileSink::sameFile(fd, filename)) {
+            FileSink::closeDescriptor(fd);
+            fd = -1;
+        }
+        if (fd < 0) fd = FileSink::openForSync(filename);
+        bool ok = fd >= 0 && FileSink::syncDescriptor(fd);
+        if (ok) m_syncCount.fetch_add(1, memory_order_relaxed);
+        lock.lock();
+        f.fd = fd;
+        f.ok = ok;
+        f.done = f.started;
+        f.running = false;
+        m_inlineSyncCv.notify_all();
+    }
+    bool ok = f.ok;
+    f.users--;
+    return ok;
+}
+
+unsigned long long Logs::Impl::settleSharedDurable() {
+    lock_guard<mutex> lock(m_sharedDurableMtx);
+    size_t kept = 0;
+    for (size_t i = 0; i < m_sharedDurable.size(); i++) {
+        SharedDurable& d = m_sharedDurable[i];
+        if (d.ring->synced(d.end)) continue;
+        if (d.ring->readerAlive()) {
+            d.ring->requestSync(d.end);
+            if (kept != i) m_sharedDurable[kept] = std::move(d);
+            kept++;
+            continue;
+        }
+        //    :    (     - )
+        size_t split = d.record.find('\0', shared_prefix);
+        if (split == string::npos) continue;
+        string filename = d.record.substr(shared_prefix, split - shared_prefix);
+        ofstream file(filename, ios::binary | ios::app);
+        if (file.is_open()) {
+            file.write(d.record.data() + split + 1, d.record.size() - split - 1);
+            file.close();
+            syncFile(filename);
+        }
+    }
+    m_sharedDurable.resize(kept);
+    if (m_sharedDurable.empty()) return m_sharedDurableSerial.load();
+    unsigned long long oldest = m_sharedDurable[0].serial;
+    for (size_t i = 1; i < m_sharedDurable.size(); i++) {
+        if (m_sharedDurable[i].serial < oldest) oldest = m_sharedDurable[i].serial;
+    }
+    return oldest - 1;
+}
+
+void Logs::Impl::waitSharedDurable() {
+    durableMark.ring->waitSynced(durableMark.end);
+    durableMark.ring = nullptr;
+    settleSharedDurable();
+}
+
+void Logs::Impl::syncWritten(Severity level, const string& filename) {
+    Durability mode = m_durability.load(memory_order_relaxed);
+    if (mode == Durability::none || (mode == Durability::on_error && level != Severity::error)) return;
+    if (mode == Durability::periodic) {
+        long long now = (long long)chrono::steady_clock::now().time_since_epoch().count();
+        long long next = m_nextInlineSync.load(memory_order_relaxed);
+        if (now < next) return;
+        chrono::steady_clock::duration interval;
+        {
+            lock_guard<mutex> lock(m_queueMtx);
+            interval = m_syncInterval;
+        }
+        //     fdatasync  
+        if (!m_nextInlineSync.compare_exchange_strong(next, now + (long long)interval.count())) return;
+    }
+    syncFile(filename);
+}
+
+bool Logs::Impl::addCompletion(bool durable, function<void()> done) {
+    lock_guard<mutex> lock(m_queueMtx);
+    if (!m_async) return false;
+    PendingCompletion completion;
+    completion.request = durable ? ++m_syncRequests : ++m_flushRequests;
+    completion.durable = durable;
+    // durable   ,       ( )
+    completion.sharedSerial = durable ? m_sharedDurableSerial.load() : 0;
+    if (completion.sharedSerial > m_sharedWanted) m_sharedWanted = completion.sharedSerial;
+    completion.done = std::move(done);
+    m_completions.push_back(std::move(completion));
+    m_queueCv.notify_all();
+    return true;
+}
+
+void Logs::Impl::runCompletions(unique_lock<mutex>& lock) {
+    vector<function<void()> > ready;
+    size_t kept = 0;
+    for (size_t i = 0; i < m_completions.size(); i++) {
+        PendingCompletion& c = m_completions[i];
+        bool done = c.durable ? m_syncDone >= c.request && m_sharedSettled >= c.sharedSerial : m_flushDone >= c.request;
+        if (done) ready.push_back(std::move(c.done));
+        else m_completions[kept++] = std::move(c);
+    }
+    m_completions.resize(kept);
+    if (ready.empty()) return;
+    lock.unlock();
+    for (size_t i = 0; i < ready.size(); i++) ready[i]();
+    lock.lock();
+}
+
+void Logs::Impl::setFormat(string format) {
+    //  -  ;         
+    shared_ptr<const LogFormat> compiled = make_shared<const LogFormat>(format);
+    lock_guard<mutex> lock(m_formatMtx);
+    m_format = compiled;
+    m_formatContext = compiled->uses(LogFormat::context_token);
+}
+
+void Logs::Impl::setFormat(const LogFormat& format) {
+    shared_ptr<const LogFormat> compiled = make_shared<const LogFormat>(format);
+    lock_guard<mutex> lock(m_formatMtx);
+    m_format = compiled;
+    m_formatContext = compiled->uses(LogFormat::context_token);
+}
+
+void Logs::Impl::setFormat() {
+    shared_ptr<const LogFormat> compiled = make_shared<const LogFormat>();
+    lock_guard<mutex> lock(m_formatMtx);
+    m_format = compiled;
+    m_formatContext = compiled->uses(LogFormat::context_token);
+}
+
+shared_ptr<const LogFormat> Logs::Impl::currentFormat() {
+    lock_guard<mutex> lock(m_formatMtx);
+    return m_format;
+}
+
+template <typename T>
+void Logs::Impl::write(Severity level, T& text, string& filename, string& sourcefile, int sourceline) {
+    if (level < m_level) return; //     INFO,   TRACE  DEBUG . 
+    if (!accept(level)) return; //    
+    output(level, text, filename, sourcefile, sourceline);
+}
+
+template <typename T>
+void Logs::Impl::output(Severity level, T& text, string& filename, string& sourcefile, int sourceline) {
+    lock_guard<mutex> lock(mutex); //    ,     
+    switch (m_out) {
+        case only_console:
+            writeConsole(level, text, sourcefile, sourceline);
+            break;
+        case only_file:
+            writeFile(level, text, filename, sourcefile, sourceline);
+            break;
+        case file_and_console:
+            writeConsole(level, text, sourcefile, sourceline);
+            writeFile(level, text, filename, sourcefile, sourceline);
+            break;
+        default:
+            writeConsole(level, text, sourcefile, sourceline);
+            break;    
+    };
+}
+
+template <typename T>
+void Logs::Impl::writeConsole(Severity& level, T& text, string& sourcefile, int& sourceline) {
+    cout << getResultedString(level, text, sourcefile, sourceline) << endl;
+}
+
+template <typename T>
+void Logs::Impl::writeFile(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline) {
+    bool defaultFile = resolveFileName(filename);
+    if (m_sharedRing.load(memory_order_relaxed) && publishShared(level, text, filename, sourcefile, sourceline)) return;
+    if (m_async) {
+        if (enqueue(level, text, filename, sourcefile, sourceline, defaultFile)) return;
+    }
+    else waitForStop();     //         
+    
+    // :         ,   
+    ofstream file(filename, ios::app);
+    if (file.is_open()) {
+        file << getResultedString(level, text, sourcefile, sourceline) << endl;
+    }
+    else {
+        cout << ":    .\n" << endl;
+        return;
+    }
+    file.close();
+    syncWritten(level, filename);
+}
+
+bool Logs::Impl::resolveFileName(string& filename) {
+    if (filename.length() == 0 || filename == "") {
+        string datetime = getDatetime("%Y-%m-%d_%X");
+        while (datetime.find(':') != std::string::npos) {
+            datetime.replace(datetime.find(':'), 1, "-");
+        }
+        filename = "log_" + datetime + ".log";
+        return true;
+    }
+    else if (filename.find(".log") == std::string::npos) {
+        filename += ".log";
+    }
+    return false;
+}
+
+string Logs::Impl::getDatetime() {
+    return getDatetime(time(0));
+}
+
+string Logs::Impl::getDatetime(time_t time_now) {
+    //         - localtime  strftime
+    //      (    )
+    static thread_local time_t cachedTime = (time_t)-1;
+    static thread_local string cachedString;
+    if (time_now == cachedTime) return cachedString;
+    char timeString[80];
+    strftime(timeString, sizeof(timeString), "%Y-%m-%d %X", localtime(&time_now));
+    cachedTime = time_now;
+    cachedString = timeString;
+    return cachedString;
+}
+
+string Logs::Impl::getDatetime(string format) {
+    time_t time_now = time(0);
+    char timeString[80];
+    strftime(timeString, sizeof(timeString), format.data(), localtime(&time_now));
+    return timeString;
+}
+
+string Logs::Impl::getLevel(Severity& level) {
+    switch (level)
+    {
+    case Severity::trace:
+        return "TRACE";
+        break;
+    case Severity::debug:
+        return "DEBUG";
+        break;
+    case Severity::info:
+        return "INFO";
+        break;
+    case Severity::warning:
+        return "WARNING";
+        break;
+    case Severity::error:
+        return "ERROR";
+        break;
+    default:
+        return "???";
+        break;
+    }
+}
+
+/**      {m} (  ,    ) */
+static LogFormat::Text messageText(const string& text) {
+    return LogFormat::text(text);
+}
+
+static LogFormat::Text messageText(const char* text) {
+    LogFormat::Text result = {text, strlen(text)};
+    return result;
+}
+
+static LogFormat::Text messageText(const LogPayload& text) {
+    return LogFormat::text(text.str());
+}
+
+template <typename T>
+string Logs::Impl::getResultedString(Severity& level, T& text, string& sourcefile, int& sourceline, time_t when, const string* context,
+    size_t* messageAt, const LogFormat* format) {
+    UsefulFunctions us;
+    shared_ptr<const LogFormat> current;
+    if (format == nullptr) {
+        current = currentFormat();
+        format = current.get();
+    }
+    if (format->empty()) {
+        string str = getDatetime(when) + " | " + getLevel(level) + ((sourcefile.length() == 0 || sourcefile == "") ? "" : " | " + sourcefile)  + ((sourceline > 0) ? " | line:" + us.toString(sourceline) : "") + " -> ";
+        if (messageAt) *messageAt = str.size();
+        str += text;
+        return str;
+    }
+    else {
+        //     ( setFormat   );    
+        LogFormat::Fields values = {};
+        string datetime, levelName, line, contextText;
+        if (format->uses(LogFormat::time_token)) {
+            datetime = getDatetime(when); // time
+            values.token[LogFormat::time_token] = LogFormat::text(datetime);
+        }
+        if (format->uses(LogFormat::level_token)) {
+            levelName = getLevel(level); // level
+            values.token[LogFormat::level_token] = LogFormat::text(levelName);
+        }
+        values.token[LogFormat::message_token] = messageText(text); // message
+        values.token[LogFormat::source_token] = LogFormat::text(sourcefile); // src file
+        if (format->uses(LogFormat::line_token)) {
+            line = us.toString(sourceline); // line in src file
+            values.token[LogFormat::line_token] = LogFormat::text(line);
+        }
+        if (format->uses(LogFormat::context_token)) {
+            // context of the record
+            if (context) values.token[LogFormat::context_token] = LogFormat::text(*context);
+            else {
+                LogContext::appendTo(contextText);
+                values.token[LogFormat::context_token] = LogFormat::text(contextText);
+            }
+        }
+        string str_form;
+        format->render(values, str_form, messageAt);
+        return str_form;
+    }
+}
+
+void Logs::Impl::collectMetrics(const string& filename, double seconds) {
+    vector<MetricSite*> sites;
+    {
+        lock_guard<mutex> lock(callSitesMutex());
+        sites = metricSites();
+    }
+    for (size_t i = 0; i < sites.size(); i++) {
+        MetricSite& site = *sites[i];
+        unsigned long long count = 0;
+        long long sum = 0, min = LLONG_MAX, max = LLONG_MIN;
+        for (int s = 0; s < counter_shards; s++) {
+            MetricSite::Shard& shard = site.shards[s];
+            count += shard.count.exchange(0, memory_order_relaxed);
+            sum += shard.sum.exchange(0, memory_order_relaxed);
+            long long lo = shard.min.exchange(LLONG_MAX, memory_order_relaxed);
+            long long hi = shard.max.exchange(LLONG_MIN, memory_order_relaxed);
+            if (lo < min) min = lo;
+            if (hi > max) max = hi;
+        }
+        if (count == 0) continue;
+        char rate[32];
+        snprintf(rate, sizeof(rate), "%.1f", seconds > 0 ? count / seconds : 0.0);
+        Record r;
+        r.level = site.level;
+        r.time = chrono::system_clock::now();
+        r.stamp = 0;
+        r.filename = filename;
+        r.defaultFile = resolveFileName(r.filename);
+        r.sourcefile = site.file;
+        r.sourceline = site.line;
+        r.text = string(site.message) + " [metric] count=" + to_string(count) + " rate=" + rate + "/s";
+        if (min <= max) {
+            char avg[32];
+            snprintf(avg, sizeof(avg), "%.1f", (double)sum / count);
+            r.text += " min=" + to_string(min) + " avg=" + avg + " max=" + to_string(max);
+        }
+        m_batch.push_back(std::move(r));
+    }
+}
+
+void Logs::Impl::parkForCrash() {
+    m_backendState = backend_parked;
+    while (true) this_thread::sleep_for(chrono::seconds(1));
+}
+
+void Logs::Impl::stampRecord(Record& r) {
+    if (m_fastTime.load(memory_order_relaxed)) {
+        r.stamp = LogClock::ticks();
+        return;
+    }
+    r.stamp = 0;
+    r.time = chrono::system_clock::now();
+}
+
+void Logs::Impl::resolveTime(Record& r) {
+    if (r.stamp == 0) return;
+    r.time = m_clock->toTime(r.stamp);
+    r.stamp = 0;
+}
+
+template <typename T>
+bool Logs::Impl::publishShared(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline) {
+    //      ,      
+    ShmLogRing* ring = m_sharedRing.load(memory_order_acquire);
+    if (!ring->readerAlive() && (ring = reconnectSharedRing(ring)) == nullptr) return false;
+    chrono::system_clock::time_point now = chrono::system_clock::now();
+    long long ns = (long long)chrono::duration_cast<chrono::nanoseconds>(now.time_since_epoch()).count();
+    string record(shared_prefix, '\0');
+    record[0] = (char)('0' + (int)level);
+    memcpy(&record[1], &ns, sizeof(ns));
+    record += filename;
+    record += '\0';
+    record += getResultedString(level, text, sourcefile, sourceline, chrono::system_clock::to_time_t(now));
+#ifdef _WIN32
+    record += "\r\n";
+#else
+    record += '\n';
+#endif
+    uint64_t end = 0;
+    if (!ring->publish(record.data(), record.size(), true, &end)) return false;
+    if (durableMark.active) {
+        //         (. settleSharedDurable)
+        SharedDurable d;
+        d.ring = ring;
+        d.end = end;
+        d.record = std::move(record);
+        lock_guard<mutex> lock(m_sharedDurableMtx);
+        d.serial = ++m_sharedDurableSerial;
+        m_sharedDurable.push_back(std::move(d));
+        durableMark.ring = ring;
+        durableMark.end = end;
+    }
+    return true;
+}
+
+size_t Logs::Impl::drainSharedRing(vector<LogSink*>& sinks, bool sinksOnly, vector<shared_ptr<Subscription> >& subscriptions) {
+    size_t count = 0;
+    ShmLogRing* ring = m_sharedRing.load(memory_order_relaxed);
+    ring->heartbeat();
+    while (ring->pop(m_sharedRecord)) {
+        if (m_crashing) parkForCrash();
+        if (m_sharedRecord.size() <= shared_prefix) continue;
+        size_t split = m_sharedRecord.find('\0', shared_prefix);
+        if (split == string::npos || split == shared_prefix) continue;
+        int level = m_sharedRecord[0] - '0';
+        long long ns;
+        memcpy(&ns, &m_sharedRecord[1], sizeof(ns));
+        chrono::system_clock::time_point time(chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(ns)));
+        size_t length;
+        const char* line = m_transcoder.convert(m_sharedRecord.data() + split + 1, m_sharedRecord.size() - split - 1, length);
+        if (!sinksOnly) {
+            string filename = m_sharedRecord.substr(shared_prefix, split - shared_prefix);
+            LogSink* sink = getFileSink(filename);
+            sink->write(line, length);
+            m_lastSink = sink;
+            if (!m_indexes.empty()) indexRecord(filename, level, time, length);
+        }
+        for (size_t j = 0; j < sinks.size(); j++) sinks[j]->writeRecord(level, line, length);
+        if (!subscriptions.empty()) publishSharedRecord(level, time, split, subscriptions);
+        count++;
+    }
+    return count;
+}
+
+void Logs::Impl::publishSharedRecord(int level, chrono::system_clock::time_point time, size_t split, vector<shared_ptr<Subscription> >& subscriptions) {
+    Record r;
+    r.level = (Severity)level;
+    r.time = time;
+    r.stamp = 0;
+    r.filename = m_sharedRecord.substr(shared_prefix, split - shared_prefix);
+    r.defaultFile = false;
+    r.sourceline = -1;
+    r.text = m_sharedRecord.substr(split + 1);
+    while (!r.text.empty() && (r.text[r.text.size() - 1] == '\n' || r.text[r.text.size() - 1] == '\r')) r.text.erase(r.text.size() - 1);
+    for (size_t j = 0; j < subscriptions.size(); j++) {
+        if (subscriptions[j]->matches(r)) subscriptions[j]->push(r);
+    }
+}
+
+unsigned long long Logs::Impl::nextSerial() {
+    static atomic<unsigned long long> serial(0);
+    return ++serial;
+}
+
+Logs::Impl::ThreadBuffer* Logs::Impl::getThreadBuffer() {
+    struct Cache {
+        vector<pair<unsigned long long, ThreadBuffer*> > items;
+        ~Cache() {
+            for (size_t i = 0; i < items.size(); i++) {
+                items[i].second->closed = true;
+                items[i].second->release();
+            }
+        }
+    };
+    static thread_local Cache cache;
+    for (size_t i = 0; i < cache.items.size(); i++) {
+        if (cache.items[i].first == m_serial) return cache.items[i].second;
+    }
+    ThreadBuffer* buffer;
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        buffer = new ThreadBuffer(m_threadBufferSize);
+        m_threadBuffers.push_back(buffer);
+    }
+    cache.items.push_back(make_pair(m_serial, buffer));
+    return buffer;
+}
+
+void Logs::Impl::takeText(Record& r, string& text) {
+    r.payload.reset();
+    size_t threshold = m_largePayload.load(memory_order_relaxed);
+    if (threshold > 0 && text.size() >= threshold) {
+        r.text.swap(text);
+        return;
+    }
+    r.text.clear();
+    r.text += text;
+}
+
+void Logs::Impl::takeText(Record& r, LogPayload& text) {
+    r.text.clear();
+    r.payload = text.shared();
+}
+
+template <typename T>
+void Logs::Impl::takeText(Record& r, T& text) {
+    r.payload.reset();
+    r.text.clear();
+    r.text += text;
+}
+
+template <typename T>
+void Logs::Impl::enqueueThreadLocal(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline, bool defaultFile) {
+    ThreadBuffer* b = getThreadBuffer();
+    size_t capacity = b->slots.size();
+    size_t tail = b->tail.load(memory_order_relaxed);
+    while (tail - b->cachedHead >= capacity) {
+        b->cachedHead = b->head.load(memory_order_acquire);
+        if (tail - b->cachedHead < capacity) break;
+        //  :   -   ,     -   
+        if (m_async) waitForSpace(b, tail);
+        else writeStopped(b);
+    }
+    Record& r = b->slots[tail % capacity];
+    r.level = level;
+    stampRecord(r);
+    r.filename = filename;
+    r.defaultFile = defaultFile;
+    r.sourcefile = sourcefile;
+    r.sourceline = sourceline;
+    takeText(r, text);
+    r.context.clear();
+    if (m_formatContext.load(memory_order_relaxed)) LogContext::appendTo(r.context);
+    b->tail.store(tail + 1, memory_order_release);
+    // ,       ;      backendLoop
+    //      :     ,      
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!m_async.load(memory_order_relaxed)) writeStopped(b);
+    else wakeBackend();
+}
+
+void Logs::Impl::wakeBackend() {
+    if (m_backendSleeping.load(memory_order_relaxed) && m_backendSleeping.exchange(false)) {
+        lock_guard<mutex> lock(m_queueMtx);
+        m_queueCv.notify_one();
+    }
+}
+
+void Logs::Impl::waitForStop() {
+    if (backendOwner == this) return;
+    lock_guard<mutex> stopLock(m_stopMtx);
+}
+
+void Logs::Impl::waitForSpace(ThreadBuffer* b, size_t tail) {
+    unique_lock<mutex> lock(m_queueMtx);
+    m_spaceWaiters++;
+    m_queueCv.notify_one();
+    while (m_async && tail - b->head.load(memory_order_acquire) >= b->slots.size()) m_spaceCv.wait(lock);
+    m_spaceWaiters--;
+}
+
+void Logs::Impl::writeStopped(ThreadBuffer* b) {
+    //   (  )     
+    if (backendOwner == this) return;
+    lock_guard<mutex> stopLock(m_stopMtx);
+    if (m_async) return;    //      -     
+    size_t head = b->head.load(memory_order_acquire);
+    size_t tail = b->tail.load(memory_order_acquire);
+    for (; head != tail; head++) {
+        Record& r = b->slots[head % b->slots.size()];
+        resolveTime(r);
+        writeRecordNow(r);
+    }
+    b->head.store(tail, memory_order_release);
+    b->cachedHead = tail;
+}
+
+void Logs::Impl::writeRecordNow(Record& r) {
+    string text = r.message();
+    string line = getResultedString(r.level, text, r.sourcefile, r.sourceline, chrono::system_clock::to_time_t(r.time), &r.context);
+    // :   ,     
+    ofstream file(r.filename, ios::app);
+    if (file.is_open()) file << line << endl;
+}
+
+void Logs::Impl::collectThreadBuffers(vector<ThreadBuffer*>& buffers, bool all) {
+    typedef chrono::system_clock::time_point time_point;
+    typedef pair<time_point, size_t> entry;
+    // ,   ,    ,  :
+    //           
+    time_point limit = all ? time_point::max() : chrono::system_clock::now() - chrono::milliseconds(merge_window_ms);
+    size_t n = buffers.size();
+    vector<size_t> heads(n), tails(n);
+    priority_queue<entry, vector<entry>, greater<entry> > heap;
+    for (size_t i = 0; i < n; i++) {
+        heads[i] = buffers[i]->head.load(memory_order_relaxed);
+        tails[i] = buffers[i]->tail.load(memory_order_acquire);
+        if (heads[i] != tails[i]) {
+            Record& r = buffers[i]->slots[heads[i] % buffers[i]->slots.size()];
+            resolveTime(r);
+            if (r.time <= limit) heap.push(entry(r.time, i));
+        }
+    }
+    //     :    ,  - 
+    //       ; head     
+    if (heap.size() == 1) {
+        //    -    
+        size_t i = heap.top().second;
+        vector<Record>& slots = buffers[i]->slots;
+        for (; heads[i] != tails[i]; heads[i]++) {
+            Record& r = slots[heads[i] % slots.size()];
+            resolveTime(r);
+            if (r.time > limit) break;
+            m_order.push_back(&r);
+            m_orderBuffer.push_back(buffers[i]);
+        }
+        return;
+    }
+    while (!heap.empty()) {
+        size_t i = heap.top().second;
+        heap.pop();
+        vector<Record>& slots = buffers[i]->slots;
+        m_order.push_back(&slots[heads[i] % slots.size()]);
+        m_orderBuffer.push_back(buffers[i]);
+        heads[i]++;
+        if (heads[i] != tails[i]) {
+            Record& r = slots[heads[i] % slots.size()];
+            resolveTime(r);
+            if (r.time <= limit) heap.push(entry(r.time, i));
+        }
+    }
+}
+
+void Logs::Impl::collectNodeQueues(vector<NodeQueue*>& queues) {
+    typedef pair<chrono::system_clock::time_point, size_t> entry;
+    size_t n = queues.size();
+    size_t nonEmpty = 0;
+    for (size_t i = 0; i < n; i++) {
+        lock_guard<mutex> lock(queues[i]->mtx);
+        queues[i]->records.swap(queues[i]->spare);
+        if (!queues[i]->spare.empty()) nonEmpty++;
+    }
+    if (nonEmpty == 0) return;
+    vector<size_t> positions(n, 0);
+    priority_queue<entry, vector<entry>, greater<entry> > heap;
+    for (size_t i = 0; i < n; i++) {
+        vector<Record>& records = queues[i]->spare;
+        for (size_t j = 0; j < records.size(); j++) resolveTime(records[j]);
+        if (!records.empty()) heap.push(entry(records[0].time, i));
+    }
+    while (!heap.empty()) {
+        size_t i = heap.top().second;
+        heap.pop();
+        vector<Record>& records = queues[i]->spare;
+        m_batch.push_back(std::move(records[positions[i]]));
+        if (++positions[i] < records.size()) heap.push(entry(records[positions[i]].time, i));
+    }
+    for (size_t i = 0; i < n; i++) queues[i]->spare.clear();
+}
+
+void Logs::Impl::releaseClosedBuffers() {
+    lock_guard<mutex> lock(m_queueMtx);
+    for (size_t i = m_threadBuffers.size(); i-- > 0;) {
+        ThreadBuffer* b = m_threadBuffers[i];
+        if (b->closed && b->head.load() == b->tail.load()) {
+            m_threadBuffers.erase(m_threadBuffers.begin() + i);
+            b->release();
+        }
+    }
+}
+
+unsigned long long Logs::Impl::rateToThreshold(double rate) {
+    if (rate >= 1.0) return 1ULL << 32;
+    if (rate <= 0.0) return 0;
+    return (unsigned long long)(rate * 4294967296.0);
+}
+
+unsigned Logs::Impl::nextRandom() {
+    static thread_local unsigned long long state = 0;
+    if (state == 0) {
+        state = (unsigned long long)hash<thread::id>()(this_thread::get_id()) ^ 
+            (unsigned long long)chrono::steady_clock::now().time_since_epoch().count();
+        if (state == 0) state = 0x9E3779B97F4A7C15ULL;
+    }
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (unsigned)((state * 2685821657736338717ULL) >> 32);
+}
+
+int Logs::Impl::counterShard() {
+    static atomic<int> next(0);
+    static thread_local int shard = next++ % counter_shards;
+    return shard;
+}
+
+Logs::Impl::ThreadCounters* Logs::Impl::threadCounters() {
+    struct Cache {
+        vector<pair<unsigned long long, ThreadCounters*> > items;
+        ~Cache() {
+            for (size_t i = 0; i < items.size(); i++) {
+                items[i].second->closed = true;
+                items[i].second->release();
+            }
+        }
+    };
+    static thread_local Cache cache;
+    for (size_t i = 0; i < cache.items.size(); i++) {
+        if (cache.items[i].first == m_serial) return cache.items[i].second;
+    }
+    ThreadCounters* counters = new ThreadCounters();
+    {
+        lock_guard<mutex> lock(m_countersMtx);
+        foldClosedCounters();
+        m_threadCounters.push_back(counters);
+    }
+    cache.items.push_back(make_pair(m_serial, counters));
+    return counters;
+}
+
+void Logs::Impl::foldClosedCounters() {
+    for (size_t t = m_threadCounters.size(); t-- > 0;) {
+        ThreadCounters* c = m_threadCounters[t];
+        if (!c->closed) continue;
+        for (int k = 0; k < 3; k++) {
+            for (int i = 0; i < level_count; i++) m_retiredCounters[k][i] += c->values[k][i].load(memory_order_relaxed);
+        }
+        m_threadCounters.erase(m_threadCounters.begin() + t);
+        c->release();
+    }
+}
+
+void Logs::Impl::countDecision(CounterKind kind, Severity level) {
+    threadCounters()->add(kind, (int)level);
+}
+
+bool Logs::Impl::accept(Severity level) {
+    int lv = (int)level;
+    if (lv < m_adaptiveLevel.load(memory_order_relaxed)) {
+        countDecision(counter_shed, level);
+        return false;
+    }
+    unsigned long long threshold = m_sampleThreshold[lv].load(memory_order_relaxed);
+    if (threshold <= 0xFFFFFFFFULL && nextRandom() >= threshold) {
+        countDecision(counter_sampled, level);
+        return false;
+    }
+    countDecision(counter_accepted, level);
+    return true;
+}
+
+void Logs::Impl::adaptLevel(size_t depth, chrono::steady_clock::duration latency) {
+    if (depth > m_maxQueueDepth) m_maxQueueDepth = depth;
+    if (!m_adaptive) return;
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    long long ms = chrono::duration_cast<chrono::milliseconds>(latency).count();
+    int level = m_adaptiveLevel;
+    int base = level < (int)m_level ? (int)m_level : level;
+    if ((depth > m_highDepth || ms > m_maxLatencyMs) && base < (int)Severity::error) {
+        //     100 ,         error
+        if (level == 0 || now - m_adaptiveChanged >= chrono::milliseconds(100)) {
+            m_adaptiveLevel = base + 1;
+            m_adaptiveChanged = now;
+            m_levelRaises++;
+        }
+    }
+    else if (level > 0 && depth < m_lowDepth && ms * 2 < m_maxLatencyMs) {
+        if (now - m_adaptiveChanged >= chrono::seconds(1)) {
+            m_adaptiveLevel = (level - 1 <= (int)m_level) ? 0 : level - 1;
+            m_adaptiveChanged = now;
+            m_levelRestores++;
+        }
+    }
+    else if (level > 0 && (depth >= m_lowDepth || ms * 2 >= m_maxLatencyMs)) {
+        //     -     
+        m_adaptiveChanged = now;
+    }
+}
+
+vector<Logs::CallSite*>& Logs::Impl::callSites() {
+    static vector<CallSite*> sites;
+    return sites;
+}
+
+vector<Logs::MetricSite*>& Logs::Impl::metricSites() {
+    static vector<MetricSite*> sites;
+    return sites;
+}
+
+mutex& Logs::Impl::callSitesMutex() {
+    static mutex mtx;
+    return mtx;
+}
+
+void Logs::Impl::crashDrain(void* ctx, const char* crash, void** frames, int nframes) {
+    static_cast<Impl*>(ctx)->emergencyDrain(crash, frames, nframes);
+}
+
+void Logs::Impl::emergencyDrain(const char* crash, void** frames, int nframes) {
+    //           : ,   
+    m_crashing = 1;
+    if (m_async && this_thread::get_id() != m_backend.get_id()) {
+        for (int i = 0; i < 500 && m_backendState == backend_running; i++) LogCrashHandler::pause(1);
+    }
+    for (map<string, OpenFile>::iterator it = m_fileSinks.begin(); it != m_fileSinks.end(); ++it) {
+        it->second.sink->emergencyFlush();
+    }
+    for (size_t i = 0; i < m_sinks.size(); i++) m_sinks[i]->emergencyFlush();
+
+    CrashWriter w(LogCrashHandler::tzOffset());
+    for (size_t i = m_batchPos; i < m_batch.size(); i++) emergencyRecord(w, m_batch[i]);
+    for (size_t i = 0; i < m_queue.size(); i++) emergencyRecord(w, m_queue[i]);
+    for (size_t i = 0; i < m_threadBuffers.size(); i++) {
+        ThreadBuffer* b = m_threadBuffers[i];
+        for (size_t j = b->head.load(); j < b->tail.load(); j++) emergencyRecord(w, b->slots[j % b->slots.size()]);
+    }
+    for (size_t i = 0; i < m_nodeQueues.size(); i++) {
+        vector<Record>& records = m_nodeQueues[i]->records;
+        for (size_t j = 0; j < records.size(); j++) emergencyRecord(w, records[j]);
+    }
+
+    int fd = m_lastSink ? m_lastSink->emergencyFlush() : -1;
+    if (fd < 0) fd = LogCrashHandler::fallbackFd();
+    w.appendDatetime((long long)time(0));
+    w.append(" | ERROR -> ");
+    w.append(crash);
+    w.append("\n");
+    w.flushTo(fd);
+#ifdef LOG_CRASH_BACKTRACE
+    backtrace_symbols_fd(frames, nframes, fd);
+#else
+    (void)frames; (void)nframes;
+#endif
+}
+
+void Logs::Impl::emergencyRecord(CrashWriter& w, Record& r) {
+    static const char* levels[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR"};
+    map<string, OpenFile>::iterator it = m_fileSinks.find(r.filename);
+    int fd = (it != m_fileSinks.end()) ? it->second.sink->emergencyFlush() : -1;
+    if (fd < 0) fd = LogCrashHandler::fallbackFd();
+    if (r.stamp) w.appendDatetime(m_clock->toNanoseconds(r.stamp) / 1000000000LL);
+    else w.appendDatetime((long long)chrono::duration_cast<chrono::seconds>(r.time.time_since_epoch()).count());
+    w.append(" | ");
+    w.append(levels[(int)r.level]);
+    if (!r.sourcefile.empty()) {
+        w.append(" | ");
+        w.append(r.sourcefile.data(), r.sourcefile.size());
+    }
+    if (r.sourceline > 0) {
+        w.append(" | line:");
+        w.appendNumber(r.sourceline);
+    }
+    w.append(" -> ");
+    w.append(r.message().data(), r.message().size());
+    w.append("\n");
+    w.flushTo(fd);
+}
+
+template <typename T>
+bool Logs::Impl::enqueue(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline, bool defaultFile) {
+    if (m_threadLocal) {
+        if (m_crashing) return true;
+        enqueueThreadLocal(level, text, filename, sourcefile, sourceline, defaultFile);
+        return true;
+    }
+    Record record;
+    record.level = level;
+    stampRecord(record);
+    record.filename = filename;
+    record.defaultFile = defaultFile;
+    record.sourcefile = sourcefile;
+    record.sourceline = sourceline;
+    takeText(record, text);
+    if (m_formatContext.load(memory_order_relaxed)) LogContext::appendTo(record.context);
+    if (m_topologyMode) {
+        NodeQueue* queue = m_nodeQueues[(size_t)m_topology->currentGroup() % m_nodeQueues.size()];
+        bool queued = false;
+        {
+            lock_guard<mutex> lock(queue->mtx);
+            if (m_async) {
+                if (m_crashing) return true;
+                queue->records.push_back(std::move(record));
+                queued = true;
+            }
+        }
+        //   :  ,   ,    
+        // (hasThreadRecords    mtx),    -    
+        if (queued) {
+            wakeBackend();
+            return true;
+        }
+        waitForStop();
+        return false;
+    }
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        if (m_async) {
+            if (m_crashing) return true;
+            m_queue.push_back(std::move(record));
+            if (m_queue.size() == 1) m_queueCv.notify_one();
+            return true;
+        }
+    }
+    waitForStop();
+    return false;
+}
+
+LogSink* Logs::Impl::getFileSink(const string& filename) {
+    map<string, OpenFile>::iterator it = m_fileSinks.find(filename);
+    if (it != m_fileSinks.end()) {
+        it->second.used = m_batchTime;
+        return it->second.sink;
+    }
+    LogCompression codec;
+    size_t blockSize;
+    int level;
+    unsigned indexInterval;
+    {
+        lock_guard<mutex> lock(m_queueMtx);
+        codec = m_compression;
+        blockSize = m_compressionBlock;
+        level = m_compressionLevel;
+        indexInterval = m_indexInterval;
+    }
+    string path = filename;
+    if (codec == LogCompression::lz4) path += ".lz4";
+    else if (codec == LogCompression::zstd) {
+#ifdef LOG_USE_ZSTD
+        path += ".zst";
+#else
+        path += ".lz4";
+#endif
+    }
+    FileSink* file = new FileSink(path, m_sinkBufferSize, m_sinkBuffers, m_datasync);
+    if (!file->isOpen()) cout << ":    .\n" << endl;
+    LogSink* sink = file;
+    if (codec != LogCompression::none) sink = new CompressedFileSink(file, codec, blockSize, level);
+    else if (indexInterval && file->isOpen()) {
+        //   -   ,     
+        m_indexes[filename] = new LogIndexWriter(path, file->size(), indexInterval);
+    }
+    OpenFile& open = m_fileSinks[filename];
+    open.sink = sink;
+    open.used = m_batchTime;
+    return sink;
+}
+
+LogSink* Logs::Impl::getDefaultSink(const string& filename, bool unsynced) {
+    if (filename != m_defaultFile) {
+        //     ( ):     
+        map<string, OpenFile>::iterator it = m_fileSinks.find(m_defaultFile);
+        if (it != m_fileSinks.end()) closeFileSink(it, unsynced);
+        m_defaultFile = filename;
+    }
+    return getFileSink(filename);
+}
+
+void Logs::Impl::closeFileSink(map<string, OpenFile>::iterator it, bool unsynced) {
+    LogSink* sink = it->second.sink;
+    if (m_lastSink == sink) m_lastSink = nullptr;
+    //   sync()      -    
+    if (unsynced) sink->sync();
+    delete sink;
+    map<string, LogIndexWriter*>::iterator index = m_indexes.find(it->first);
+    if (index != m_indexes.end()) {
+        delete index->second;
+        m_indexes.erase(index);
+    }
+    m_fileSinks.erase(it);
+}
+
+void Logs::Impl::closeIdleSinks(bool unsynced) {
+    chrono::steady_clock::time_point limit = m_batchTime - chrono::seconds(sink_idle_seconds);
+    for (map<string, OpenFile>::iterator it = m_fileSinks.begin(); it != m_fileSinks.end();) {
+        map<string, OpenFile>::iterator current = it++;
+        if (current->second.used < limit) closeFileSink(current, unsynced);
+    }
+}
+
+void Logs::Impl::indexRecord(const string& filename, int level, chrono::system_clock::time_point time, size_t length) {
+    map<string, LogIndexWriter*>::iterator it = m_indexes.find(filename);
+    if (it == m_indexes.end()) return;
+    it->second->add(level, (long long)chrono::duration_cast<chrono::nanoseconds>(time.time_since_epoch()).count(), length);
+}
+
+bool Logs::Impl::flushSinks(vector<LogSink*>& sinks) {
+    for (map<string, OpenFile>::iterator it = m_fileSinks.begin(); it != m_fileSinks.end(); ++it) {
+        it->second.sink->flush();
+    }
+    bool pending = false;
+    for (size_t i = 0; i < sinks.size(); i++) {
+        sinks[i]->flush();
+        if (sinks[i]->pending()) pending = true;
+    }
+    for (map<string, LogIndexWriter*>::iterator it = m_indexes.begin(); it != m_indexes.end(); ++it) {
+        it->second->flush();
+    }
+    return pending;
+}
+
+bool Logs::Impl::syncSinks(vector<LogSink*>& sinks) {
+    for (map<string, OpenFile>::iterator it = m_fileSinks.begin(); it != m_fileSinks.end(); ++it) {
+        it->second.sink->sync();
+    }
+    bool pending = false;
+    for (size_t i = 0; i < sinks.size(); i++) {
+        sinks[i]->sync();
+        if (sinks[i]->pending()) pending = true;
+    }
+    for (map<string, LogIndexWriter*>::iterator it = m_indexes.begin(); it != m_indexes.end(); ++it) {
+        it->second->flush();
+    }
+    m_syncCount.fetch_add(1, memory_order_relaxed);
+    return pending;
+}
+
+bool Logs::Impl::hasThreadRecords() {
+    for (size_t i = 0; i < m_threadBuffers.size(); i++) {
+        if (m_threadBuffers[i]->head.load() != m_threadBuffers[i]->tail.load()) return true;
+    }
+    for (size_t i = 0; i < m_nodeQueues.size(); i++) {
+        lock_guard<mutex> lock(m_nodeQueues[i]->mtx);
+        if (!m_nodeQueues[i]->records.empty()) return true;
+    }
+    return false;
+}
+
+void Logs::Impl::backendLoop() {
+    vector<LogSink*> sinks;
+    vector<ThreadBuffer*> buffers;
+    vector<NodeQueue*> nodeQueues;
+    vector<shared_ptr<Subscription> > subscriptions;
+    bool sinksOnly = false;
+    bool dirty = false;
+    bool sinkPending = false;   //       flush() -  
+    bool unsynced = false;      //    fdatasync
+    chrono::steady_clock::time_point nextSync = chrono::steady_clock::now();
+    chrono::steady_clock::time_point nextIdleCheck = nextSync;
+    unsigned backendSettings = 0;
+    string noText;              //    :     
+    shared_ptr<const LogFormat> format;
+    backendOwner = this;
+    unique_lock<mutex> lock(m_queueMtx);
+    while (true) {
+        if (backendSettings != m_backendSettings) {
+            //         
+            backendSettings = m_backendSettings;
+            vector<int> cpus = m_backendCpus;
+            int priority = m_backendPriority;
+            lock.unlock();
+            LogTopology::pinCurrentThread(cpus);
+            if (priority != 0) LogTopology::setCurrentPriority(priority);
+            lock.lock();
+        }
+        if (m_queue.empty() && !m_stop && ((m_flushRequests == m_flushDone && m_syncRequests == m_syncDone) || sinkPending)) {
+            //       -   
+            chrono::steady_clock::duration timeout = chrono::milliseconds(!m_sharedDrain ? 100 : 1);
+            if (!m_threadBuffers.empty() || !m_nodeQueues.empty()) {
+                //        ,     (. wakeBackend);
+                // ,      ,   
+                m_backendSleeping = true;
+                if (hasThreadRecords()) {
+                    m_backendSleeping = false;
+                    timeout = chrono::milliseconds(merge_window_ms);
+                }
+            }
+            if (sinkPending && timeout > chrono::milliseconds(pending_retry_ms)) timeout = chrono::milliseconds(pending_retry_ms);
+            //        - 
+            if (m_sharedWanted > m_sharedSettled) timeout = chrono::milliseconds(1);
+            if (unsynced && m_durability == Durability::periodic) {
+                chrono::steady_clock::duration untilSync = nextSync - chrono::steady_clock::now();
+                if (untilSync < timeout) timeout = untilSync > chrono::steady_clock::duration::zero() ? untilSync : chrono::milliseconds(1);
+            }
+            m_backendState = backend_waiting;
+            m_queueCv.wait_for(lock, timeout);
+            m_backendState = backend_running;
+            m_backendSleeping = false;
+        }
+        if (m_crashing) parkForCrash();
+        m_batch.swap(m_queue);
+        m_batchPos = 0;
+        unsigned long long request = m_flushRequests;
+        bool flushRequested = request != m_flushDone;
+        unsigned long long syncRequest = m_syncRequests;
+        bool syncRequested = syncRequest != m_syncDone;
+        Durability durability = m_durability;
+        chrono::steady_clock::duration syncInterval = m_syncInterval;
+        bool stop = m_stop;
+        bool spaceWanted = m_spaceWaiters > 0;
+        bool sharedWanted = m_sharedWanted > m_sharedSettled;
+        sinks = m_sinks;
+        buffers = m_threadBuffers;
+        nodeQueues = m_nodeQueues;
+        subscriptions = m_subscriptions;
+        sinksOnly = m_sinksOnly && !sinks.empty();
+        bool metricsDue = false;
+        string metricsFile;
+        double metricsSeconds = 0;
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        m_batchTime = now;
+        if (m_metrics && (stop || now >= m_nextMetrics)) {
+            metricsDue = true;
+            metricsFile = m_metricsFile;
+            metricsSeconds = chrono::duration<double>(now - m_lastMetrics).count();
+            m_lastMetrics = now;
+            m_nextMetrics = now + m_metricsInterval;
+        }
+        if (m_clock && now >= m_nextCalibration) {
+            m_clock->calibrate();
+            m_nextCalibration = now + chrono::seconds(1);
+        }
+        if (m_transcoder.from() != m_encodingFrom || m_transcoder.to() != m_encodingTo) {
+            m_transcoder = LogTranscoder(m_encodingFrom, m_encodingTo);
+        }
+        lock.unlock();
+        format = currentFormat();   //     
+        //  : ,    ,  ,   ,
+        //  ,  m_async == false    (. enqueueThreadLocal)
+        if (stop) atomic_thread_fence(memory_order_seq_cst);
+        if (!buffers.empty()) collectThreadBuffers(buffers, flushRequested || syncRequested || stop || spaceWanted);
+        if (!nodeQueues.empty()) collectNodeQueues(nodeQueues);
+        if (metricsDue) collectMetrics(metricsFile, metricsSeconds);
+        for (size_t i = 0; i < m_batch.size(); i++) {
+            m_order.push_back(&m_batch[i]);
+            m_orderBuffer.push_back(nullptr);
+        }
+
+        chrono::steady_clock::time_point batchStart = chrono::steady_clock::now();
+        size_t depth = m_order.size();
+        bool errorWritten = false;
+        //   ,       
+        for (size_t i = 0; i < m_order.size(); i++) {
+            if (m_crashing) parkForCrash();
+            Record& r = *m_order[i];
+            resolveTime(r);
+            time_t when = chrono::system_clock::to_time_t(r.time);
+            size_t largePayload = m_largePayload.load(memory_order_relaxed);
+            //      :    
+            bool split = (r.payload || (largePayload > 0 && r.text.size() >= largePayload)) && !m_transcoder.active();
+            size_t messageAt = string::npos;
+            string line;
+            if (split) line = getResultedString(r.level, noText, r.sourcefile, r.sourceline, when, &r.context, &messageAt, format.get());
+            else if (r.payload) {
+                string text = *r.payload;
+                line = getResultedString(r.level, text, r.sourcefile, r.sourceline, when, &r.context, nullptr, format.get());
+            }
+            else line = getResultedString(r.level, r.text, r.sourcefile, r.sourceline, when, &r.context, nullptr, format.get());
+#ifdef _WIN32
+            line += "\r\n";
+#else
+            line += '\n';
+#endif
+            size_t length;
+            const char* data = m_transcoder.convert(line.data(), line.size(), length);
+            LogSlice parts[3];
+            size_t partCount = 0;
+            if (split && messageAt != string::npos) {
+                const string& message = r.message();
+                parts[0].data = line.data();
+                parts[0].len = messageAt;
+                parts[1].data = message.data();
+                parts[1].len = message.size();
+                parts[2].data = line.data() + messageAt;
+                parts[2].len = line.size() - messageAt;
+                partCount = 3;
+                length = line.size() + message.size();
+            }
+            if (!sinksOnly) {
+                LogSink* sink = r.defaultFile ? getDefaultSink(r.filename, unsynced || i > 0) : getFileSink(r.filename);
+                if (partCount) sink->writeParts(parts, partCount);
+                else sink->write(data, length);
+                m_lastSink = sink;
+                if (!m_indexes.empty()) indexRecord(r.filename, (int)r.level, r.time, length);
+            }
+            for (size_t j = 0; j < sinks.size(); j++) {
+                if (partCount) sinks[j]->writeRecordParts((int)r.level, parts, partCount);
+                else sinks[j]->writeRecord((int)r.level, data, length);
+            }
+            for (size_t j = 0; j < subscriptions.size(); j++) {
+                if (subscriptions[j]->matches(r)) subscriptions[j]->push(r);
+            }
+            if (r.level == Severity::error) errorWritten = true;
+            //     :     
+            ThreadBuffer* b = m_orderBuffer[i];
+            if (b) b->head.store(b->head.load(memory_order_relaxed) + 1, memory_order_release);
+            else m_batchPos = m_batchPos + 1;
+        }
+        if (!buffers.empty()) {
+            releaseClosedBuffers();
+            if (spaceWanted) {
+                lock_guard<mutex> spaceLock(m_queueMtx);
+                m_spaceCv.notify_all();
+            }
+        }
+        //   : fdatasync,   ,     
+        ShmLogRing* ring = m_sharedDrain ? m_sharedRing.load(memory_order_relaxed) : nullptr;
+        bool ringSync = false;
+        uint64_t ringPos = 0;
+        if (ring) {
+            ringSync = ring->syncWanted();
+            depth += drainSharedRing(sinks, sinksOnly, subscriptions);
+            ringPos = ring->readPosition();
+        }
+        bool idle = depth == 0;
+        if (!idle) dirty = unsynced = true;
+        if (now >= nextIdleCheck) {
+            closeIdleSinks(unsynced);
+            nextIdleCheck = now + chrono::seconds(1);
+        }
+        adaptLevel(depth, chrono::steady_clock::now() - batchStart);
+        m_batch.clear();
+        m_order.clear();
+        m_orderBuffer.clear();
+        m_batchPos = 0;
+        if (m_crashing) parkForCrash();
+        bool syncDue = syncRequested || ringSync || (durability == Durability::on_error && errorWritten) || 
+            (durability == Durability::periodic && chrono::steady_clock::now() >= nextSync);
+        if (unsynced && syncDue) {
+            //  :  fdatasync        sync()
+            dirty = sinkPending = syncSinks(sinks);
+            unsynced = false;
+            nextSync = chrono::steady_clock::now() + syncInterval;
+        }
+        else if (dirty && (flushRequested || idle || stop)) {
+            //       :    
+            dirty = sinkPending = flushSinks(sinks);
+        }
+        if (ringSync && !unsynced) ring->acknowledgeSync(ringPos);
+        unsigned long long settled = sharedWanted ? settleSharedDurable() : 0;
+
+        lock.lock();
+        if (!dirty && m_flushDone != request) {
+            m_flushDone = request;
+            m_flushCv.notify_all();
+        }
+        if (!unsynced && m_syncDone != syncRequest) {
+            m_syncDone = syncRequest;
+            m_flushCv.notify_all();
+        }
+        if (sharedWanted && settled > m_sharedSettled) m_sharedSettled = settled;
+        if (!m_completions.empty()) runCompletions(lock);
+        if (stop && m_queue.empty() && !hasThreadRecords() && m_sharedWanted <= m_sharedSettled) break;
+    }
+}
+
+Logs::CallSite::CallSite(const char* file, int line, double rate) : file(file), line(line), threshold(Impl::rateToThreshold(rate)), 
+    kept(0), dropped(0) {
+    lock_guard<mutex> lock(Impl::callSitesMutex());
+    Impl::callSites().push_back(this);
+}
+
+Logs::MetricSite::MetricSite(const char* file, int line, Severity level, const char* message) : file(file), line(line), level(level), 
+    message(message) {
+    for (int i = 0; i < counter_shards; i++) {
+        shards[i].count = 0;
+        shards[i].sum = 0;
+        shards[i].min = LLONG_MAX;
+        shards[i].max = LLONG_MIN;
+    }
+    lock_guard<mutex> lock(Impl::callSitesMutex());
+    Impl::metricSites().push_back(this);
+}
+
+void Logs::MetricSite::add(long long value, bool hasValue) {
+    Shard& s = shards[Impl::counterShard()];
+    s.count.fetch_add(1, memory_order_relaxed);
+    if (!hasValue) return;
+    s.sum.fetch_add(value, memory_order_relaxed);
+    long long current = s.min.load(memory_order_relaxed);
+    while (value < current && !s.min.compare_exchange_weak(current, value, memory_order_relaxed)) {}
+    current = s.max.load(memory_order_relaxed);
+    while (value > current && !s.max.compare_exchange_weak(current, value, memory_order_relaxed)) {}
+}
+
+bool Logs::Subscription::wait(Record& record, int timeoutMs) {
+    chrono::steady_clock::time_point until = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+    while (!poll(record)) {
+        if (chrono::steady_clock::now() >= until) return false;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return true;
+}
+
+//   Logs   
+
+Logs::Logs() : m_impl(new Impl()) {}
+
+Logs::~Logs() {
+    delete m_impl;
+}
+
+Logs* Logs::getInstance() {
+    lock_guard<mutex> lock(Impl::m_mtx); //  
+    if (Impl::m_instance == nullptr) {
+        Impl::m_instance = new Logs();
+        atexit(&Impl::shutdownInstance);
+    }
+    return Impl::m_instance;
+}
+
+void Logs::setOutput(Output out) {
+    m_impl->m_out = out;
+}
+
+void Logs::setAsync(bool async, size_t bufferSize, int buffers, bool datasync) {
+    m_impl->setAsync(async, bufferSize, buffers, datasync);
+}
+
+void Logs::setThreadLocal(bool enabled, size_t capacity) {
+    m_impl->setThreadLocal(enabled, capacity);
+}
+
+void Logs::setLargePayload(size_t threshold) {
+    m_impl->setLargePayload(threshold);
+}
+
+void Logs::setTopology(bool enabled, int groups, const vector<int>& backendCpus, int priority) {
+    m_impl->setTopology(enabled, groups, backendCpus, priority);
+}
+
+bool Logs::setSharedRing(const string& name, bool drain, size_t slots, size_t slotSize) {
+    return m_impl->setSharedRing(name, drain, slots, slotSize);
+}
+
+void Logs::setFastTimestamps(bool enabled) {
+    m_impl->setFastTimestamps(enabled);
+}
+
+void Logs::setCompression(LogCompression codec, size_t blockSize, int level) {
+    m_impl->setCompression(codec, blockSize, level);
+}
+
+void Logs::setIndex(unsigned interval) {
+    m_impl->setIndex(interval);
+}
+
+void Logs::setEncoding(LogEncoding from, LogEncoding to) {
+    m_impl->setEncoding(from, to);
+}
+
+void Logs::setSampling(Severity level, double rate) {
+    m_impl->setSampling(level, rate);
+}
+
+void Logs::setAdaptive(bool enabled, size_t highDepth, size_t lowDepth, int maxLatencyMs) {
+    m_impl->setAdaptive(enabled, highDepth, lowDepth, maxLatencyMs);
+}
+
+Logs::Stats Logs::getStats() {
+    return m_impl->getStats();
+}
+
+string Logs::getCallSiteStats() {
+    return Impl::getCallSiteStats();
+}
+
+template <typename T>
+void Logs::writeSampled(CallSite& site, Severity level, T text) {
+    m_impl->writeSampled(site, level, text);
+}
+
+void Logs::setMetrics(bool enabled, int intervalMs, const string& filename) {
+    m_impl->setMetrics(enabled, intervalMs, filename);
+}
+
+void Logs::writeMetric(MetricSite& site, long long value, bool hasValue) {
+    m_impl->writeMetric(site, value, hasValue);
+}
+
+void Logs::addSink(LogSink* sink, bool exclusive) {
+    m_impl->addSink(sink, exclusive);
+}
+
+shared_ptr<Logs::Subscription> Logs::subscribe(const Filter& filter, size_t capacity) {
+    return m_impl->subscribe(filter, capacity);
+}
+
+void Logs::unsubscribe(const shared_ptr<Subscription>& subscription) {
+    m_impl->unsubscribe(subscription);
+}
+
+void Logs::installCrashHandler(const string& crashFile) {
+    m_impl->installCrashHandler(crashFile);
+}
+
+void Logs::flush() {
+    m_impl->flush();
+}
+
+void Logs::setDurability(Durability mode, int intervalMs) {
+    m_impl->setDurability(mode, intervalMs);
+}
+
+void Logs::sync() {
+    m_impl->sync();
+}
+
+template <typename T>
+void Logs::writeDurable(Severity level, T text, string filename, string sourcefile, int sourceline) {
+    m_impl->writeDurable(level, text, filename, sourcefile, sourceline);
+}
+
+template <typename T>
+Logs::Completion Logs::writeDurableAsync(Severity level, T text, string filename, string sourcefile, int sourceline) {
+    m_impl->writeDurableAsync(level, text, filename, sourcefile, sourceline);
+    return syncAsync();
+}
+
+bool Logs::addCompletion(bool durable, function<void()> done) {
+    return m_impl->addCompletion(durable, done);
+}
+
+void Logs::setLevel(Severity level) {
+    m_impl->m_level = level;
+}
+
+void Logs::setFormat(string format) {
+    m_impl->setFormat(format);
+}
+
+void Logs::setFormat(const LogFormat& format) {
+    m_impl->setFormat(format);
+}
+
+void Logs::setFormat() {
+    m_impl->setFormat();
+}
+
+template <typename T>
+void Logs::write(Severity level, T text, string filename, string sourcefile, int sourceline) {
+    m_impl->write(level, text, filename, sourcefile, sourceline);
+}
+
+template <typename T>
+void Logs::writeConsole(Severity& level, T& text, string& sourcefile, int& sourceline) {
+    m_impl->writeConsole(level, text, sourcefile, sourceline);
+}
+
+template <typename T>
+void Logs::writeFile(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline) {
+    m_impl->writeFile(level, text, filename, sourcefile, sourceline);
+}
+
+string Logs::getDatetime() {
+    return m_impl->getDatetime();
+}
+
+string Logs::getDatetime(time_t time_now) {
+    return m_impl->getDatetime(time_now);
+}
+
+string Logs::getDatetime(string format) {
+    return m_impl->getDatetime(format);
+}
+
+string Logs::getLevel(Severity& level) {
+    return m_impl->getLevel(level);
+}
+
+template <typename T>
+string Logs::getResultedString(Severity& level, T& text, string& sourcefile, int& sourceline, time_t when, const string* context,
+    size_t* messageAt, const LogFormat* format) {
+    return m_impl->getResultedString(level, text, sourcefile, sourceline, when, context, messageAt, format);
+}
+
+/**      : ,    LogPayload.
+ *   write()  getResultedString()    logs.h   
+ *    .      string  .
+ */
+#define LOGS_INSTANTIATE(T) \
+    template void Logs::write<T>(Severity, T, string, string, int); \
+    template void Logs::writeSampled<T>(CallSite&, Severity, T); \
+    template void Logs::writeConsole<T>(Severity&, T&, string&, int&); \
+    template void Logs::writeDurable<T>(Severity, T, string, string, int); \
+    template Logs::Completion Logs::writeDurableAsync<T>(Severity, T, string, string, int); \
+    template void Logs::writeFile<T>(Severity&, T&, string&, string&, int&); \
+    template string Logs::getResultedString<T>(Severity&, T&, string&, int&, time_t, const string*, size_t*, const LogFormat*);
+
+LOGS_INSTANTIATE(string)
+LOGS_INSTANTIATE(LogPayload)
+LOGS_INSTANTIATE(const char*)
+LOGS_INSTANTIATE(char*)
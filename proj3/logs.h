@@ -1,14 +1,32 @@
 #ifndef LOGS_H
 #define LOGS_H
 
-#include <iostream>
 #include <string>
 #include <ctime>
-#include <fstream>
-#include <mutex>
-#include "UsefulFunctions.h"
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <functional>
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define LOGS_COROUTINES 1
+#endif
+#endif
+#include "log_format.h"
+#include "log_context.h"
 using namespace std;
 
+/**  Logs   logs.cpp (       liblogs.a),
+ *      :   (Logs::Impl), ,  ,
+ *  , ,    ..      .
+ *  setCompression  addSink  log_compress.h / log_net_sink.h,  setEncoding - log_encoding.h.
+ */
+class LogSink;
+enum class LogCompression;
+enum class LogEncoding;
+
 /** :     . */
 #define LOGE(message) Logs::getInstance()->write(Logs::Severity::error, message)
 #define LOGW(message) Logs::getInstance()->write(Logs::Severity::warning, message)
@@ -16,6 +34,42 @@ using namespace std;
 #define LOGD(message) Logs::getInstance()->write(Logs::Severity::debug, message)
 #define LOGT(message) Logs::getInstance()->write(Logs::Severity::trace, message)
 
+/**    : ,      (fdatasync).
+ *        fdatasync.
+ */
+#define LOGE_SYNC(message) Logs::getInstance()->writeDurable(Logs::Severity::error, message)
+
+/**      :  Logs::Completion,  ,
+ *    .  (C++20): co_await LOGE_DURABLE("payment failed");
+ *   : LOGE_DURABLE("payment failed").then(callback);
+ */
+#define LOGE_DURABLE(message) Logs::getInstance()->writeDurableAsync(Logs::Severity::error, message)
+
+/**      :   rate (0..1)    .
+ * : LOGD_SAMPLED("cache miss", 0.01) -     1% .
+ */
+#define LOG_SAMPLED(level, rate, message) do { \
+        static Logs::CallSite logs_call_site_(__FILE__, __LINE__, rate); \
+        Logs::getInstance()->writeSampled(logs_call_site_, level, message); \
+    } while (0)
+#define LOGI_SAMPLED(message, rate) LOG_SAMPLED(Logs::Severity::info, rate, message)
+#define LOGD_SAMPLED(message, rate) LOG_SAMPLED(Logs::Severity::debug, rate, message)
+#define LOGT_SAMPLED(message, rate) LOG_SAMPLED(Logs::Severity::trace, rate, message)
+
+/**  :    (setMetrics)     
+ * (   value),            .
+ *      . message    .
+ * : LOGI_COUNT("cache miss"); LOGI_VALUE("request handled, us", elapsedUs);
+ */
+#define LOG_METRIC(level, message, value, hasValue) do { \
+        static Logs::MetricSite logs_metric_site_(__FILE__, __LINE__, level, message); \
+        Logs::getInstance()->writeMetric(logs_metric_site_, value, hasValue); \
+    } while (0)
+#define LOGI_COUNT(message) LOG_METRIC(Logs::Severity::info, message, 0, false)
+#define LOGD_COUNT(message) LOG_METRIC(Logs::Severity::debug, message, 0, false)
+#define LOGI_VALUE(message, value) LOG_METRIC(Logs::Severity::info, message, value, true)
+#define LOGD_VALUE(message, value) LOG_METRIC(Logs::Severity::debug, message, value, true)
+
 /**   */
 // https://habr.com/ru/companies/otus/articles/779914/
 // https://logging.apache.org/log4j/2.x/manual/customloglevels.html
@@ -23,10 +77,43 @@ using namespace std;
 // https://habr.com/ru/articles/543666/
 // https://github.com/isocpp/CppCoreGuidelines/blob/master/CppCoreGuidelines.md#enum5-dont-use-all_caps-for-enumerators
 
+/**     ( ,  ):   
+ * .        ,      
+ *   (. Logs::setLargePayload). :
+ *   auto body = make_shared<const string>(readBody());
+ *   Logs::getInstance()->write(Logs::Severity::debug, LogPayload(body), "requests");
+ */
+class LogPayload {
+public:
+    explicit LogPayload(shared_ptr<const string> text) : m_text(text ? text : make_shared<const string>()) {}
+
+    explicit LogPayload(string&& text) : m_text(make_shared<const string>(std::move(text))) {}
+
+    const string& str() const {
+        return *m_text;
+    }
+
+    const shared_ptr<const string>& shared() const {
+        return m_text;
+    }
+
+private:
+    shared_ptr<const string> m_text;
+};
+
+/**  LogPayload    (,  ,  ) */
+inline string operator+(const string& head, const LogPayload& payload) {
+    return head + payload.str();
+}
+
+inline string& operator+=(string& out, const LogPayload& payload) {
+    return out += payload.str();
+}
+
 class Logs {
 private:
-    /**      */
-    static mutex m_mtx; 
+    /**      (  logs.cpp) */
+    struct Impl;
 
 public:
 
@@ -36,20 +123,223 @@ public:
     /**   . : (onlyfile) */
     enum Output {only_file, only_console, file_and_console};
 
-    /**     */
-    Output m_out;
+    /**      (. setDurability).
+     * none -  fdatasync, on_error -    , periodic -     
+     */
+    enum class Durability {none, on_error, periodic};
 
-    /**    */
-    Severity m_level;
-    
-    /**   */
-    static Logs* m_instance;
+    /**  ,     */
+    struct Record {
+        Severity level;
+        chrono::system_clock::time_point time;
+        unsigned long long stamp;           //   LogClock,        time (0 -    time)
+        string filename;
+        bool defaultFile;                   // filename -    (log_<>_<>.log)
+        string sourcefile;
+        int sourceline;
+        string text;
+        string context;                     //    (LogContext)   ,     {ctx}
+        shared_ptr<const string> payload;   //  LogPayload  ;  text 
 
-    /**       */
-    string m_format;
+        /**    */
+        const string& message() const {
+            return payload ? *payload : text;
+        }
+    };
+
+    /**    */
+    static const int level_count = 5;
+
+    /**       (. LOG_SAMPLED) */
+    struct CallSite {
+        const char* file;
+        int line;
+        unsigned long long threshold;
+        atomic<unsigned long long> kept;
+        atomic<unsigned long long> dropped;
+
+        CallSite(const char* file, int line, double rate);
+    };
+
+    /**    -:     - */
+    static const int counter_shards = 16;
+
+    /**  - (. LOG_METRIC):   min//max ,    */
+    struct MetricSite {
+        struct Shard {
+            atomic<unsigned long long> count;
+            atomic<long long> sum;
+            atomic<long long> min;
+            atomic<long long> max;
+            char pad[32];
+        };
+
+        const char* file;
+        int line;
+        Severity level;
+        const char* message;
+        Shard shards[counter_shards];
+
+        MetricSite(const char* file, int line, Severity level, const char* message);
+
+        void add(long long value, bool hasValue);
+    };
+
+    /**    (, . getStats) */
+    struct Stats {
+        unsigned long long accepted[level_count];   //   
+        unsigned long long sampledOut[level_count]; //       
+        unsigned long long shed[level_count];       //   
+        unsigned long long levelRaises;             //     
+        unsigned long long levelRestores;           //    
+        Severity effectiveLevel;                    //   
+        size_t maxQueueDepth;                       //  ,   
+        unsigned long long syncs;                   //    fdatasync (   )
+    };
+
+    /**  :    level,   category ( - ),
+     *   substring ( - )
+     */
+    struct Filter {
+        Severity level;
+        string category;
+        string substring;
+
+        Filter(Severity level = Severity::trace, const string& category = "", const string& substring = "") : 
+            level(level), category(category), substring(substring) {}
+    };
+
+    /**     (flushAsync)     (syncAsync)   .
+     *  - then(callback) ,  C++20, co_await.     
+     *     ,        flush()/sync().
+     *      ,       via().
+     * : co_await Logs::getInstance()->flushAsync().via([&](function<void()> f) { loop.post(f); });
+     *     :    , co_await  .
+     */
+    class Completion {
+    public:
+        typedef function<void(function<void()>)> Post;
+
+        Completion(Logs* log, bool durable) : m_log(log), m_durable(durable) {}
+
+        /**      
+         * @param post - ,       
+        */
+        Completion via(Post post) const {
+            Completion completion(*this);
+            completion.m_post = post;
+            return completion;
+        }
+
+        /**   : ,  ,   ,
+         *  (  fdatasync  syncAsync)
+        */
+        void then(function<void()> done) {
+            if (!m_log->addCompletion(m_durable, wrap(done))) done();
+        }
+
+#ifdef LOGS_COROUTINES
+        bool await_ready() const {
+            return false;
+        }
+
+        bool await_suspend(coroutine_handle<> handle) {
+            return m_log->addCompletion(m_durable, wrap([handle]() { handle.resume(); }));
+        }
+
+        void await_resume() const {}
+#endif
+
+    private:
+        Logs* m_log;
+        bool m_durable;
+        Post m_post;
+
+        function<void()> wrap(function<void()> done) const {
+            if (!m_post) return done;
+            Post post = m_post;
+            return [post, done]() { post(done); };
+        }
+    };
+
+    /**     (. subscribe).
+     *           ( ,
+     *  ,  ).       ,    
+     *     dropped() -   ,     .
+     */
+    class Subscription {
+    public:
+        /**    (  -)
+         * @param record -  ()
+         * @return false,    
+        */
+        bool poll(Record& record) {
+            size_t head = m_head.load(memory_order_relaxed);
+            if (head == m_tail.load(memory_order_acquire)) return false;
+            swap(record, m_slots[head % m_slots.size()]);
+            m_head.store(head + 1, memory_order_release);
+            return true;
+        }
+
+        /**   
+         * @param record -  ()
+         * @param timeoutMs -   , 
+         * @return false,       
+        */
+        bool wait(Record& record, int timeoutMs);
+
+        /**  ,   */
+        unsigned long long received() const {
+            return m_received.load(memory_order_relaxed);
+        }
+
+        /**  ,  -   */
+        unsigned long long dropped() const {
+            return m_dropped.load(memory_order_relaxed);
+        }
+
+        const Filter& filter() const {
+            return m_filter;
+        }
+
+    private:
+        friend struct Logs::Impl;
+
+        Filter m_filter;
+        vector<Record> m_slots;
+        char pad0[64];
+        atomic<size_t> m_head;      //   
+        char pad1[64];
+        atomic<size_t> m_tail;      //    
+        atomic<unsigned long long> m_received;
+        atomic<unsigned long long> m_dropped;
+
+        Subscription(const Filter& filter, size_t capacity) : m_filter(filter), m_slots(capacity ? capacity : 1), 
+            m_head(0), m_tail(0), m_received(0), m_dropped(0) {}
+
+        bool matches(const Record& r) const {
+            return r.level >= m_filter.level && (m_filter.category.empty() || r.filename == m_filter.category) && 
+                (m_filter.substring.empty() || r.message().find(m_filter.substring) != string::npos);
+        }
+
+        /**    (  );      */
+        void push(const Record& r) {
+            size_t tail = m_tail.load(memory_order_relaxed);
+            if (tail - m_head.load(memory_order_acquire) >= m_slots.size()) {
+                m_dropped.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+            m_slots[tail % m_slots.size()] = r;
+            m_tail.store(tail + 1, memory_order_release);
+            m_received.fetch_add(1, memory_order_relaxed);
+        }
+    };
 
     /**   */
-    Logs() {} 
+    Logs();
+
+    /** :   ,       */
+    ~Logs();
 
     /**    */
     Logs(const Logs &log) = delete;
@@ -59,46 +349,272 @@ public:
  
     /**  
      *     
-     *     
+     *     .    (exit,   main)
+     *       
      * @return      
      */
-    static Logs* getInstance() {
-        lock_guard<mutex> lock(m_mtx); //  
-        if (m_instance == nullptr) {
-            m_instance = new Logs();
-        }
-        return m_instance;
-    }   
+    static Logs* getInstance();
 
     /**     
      * @param out -   
     */
-    void setOutput(Output out) {
-        m_out = out;
+    void setOutput(Output out);
+
+    /** /    .
+     *    write()     ,    
+     *        FileSink (io_uring/pwritev).
+     *     .
+     * @param async - true -  , false -  (  )
+     * @param bufferSize -     .  : 1 
+     * @param buffers -    .  : 4
+     * @param datasync -  fdatasync   .  : false
+    */
+    void setAsync(bool async, size_t bufferSize = 1 << 20, int buffers = 4, bool datasync = false);
+
+    /** /     .
+     *             
+     *  --,         
+     *     (k-way merge),       .
+     * ,       (2 ),     .
+     *      .
+     * @param enabled - true -  , false -  
+     * @param capacity -      .  : 8192
+    */
+    void setThreadLocal(bool enabled, size_t capacity = 8192);
+
+    /**      .   threshold   :
+     * ,   write(),    ,      -
+     *  (, , )    ,   
+     *  ,     pwritev  . LogPayload   
+     *   .   (setEncoding)   ,  .
+     * @param threshold -    ; 0 -  ( LogPayload).  : 4096
+    */
+    void setLargePayload(size_t threshold = 4096);
+
+    /** /     ( NUMA)   .
+     *       ,   ,    :
+     *       ,  -,       .
+     *           .   
+     *  .          ,  
+     *     (, ,    ).    
+     *  .
+     * @param enabled - true -    , false -  
+     * @param groups - 0 -    NUMA, N -    N  .  : 0
+     * @param backendCpus -   ;  -  .  : 
+     * @param priority -      nice (-20..19), 0 -  .  : 0
+    */
+    void setTopology(bool enabled, int groups = 0, const vector<int>& backendCpus = vector<int>(), int priority = 0);
+
+    /**           .
+     *             
+     *  ,   -         -
+     *       .    
+     * ;      ,   .  
+     *       .     ; 
+     *  ,      ,     100  
+     *    -        .
+     * @param name -  ,    ,  "/proj_logger"
+     * @param drain - true -        (   )
+     * @param slots -   .  : 65536
+     * @param slotSize -    .  : 256
+     * @return true,   
+    */
+    bool setSharedRing(const string& name, bool drain, size_t slots = 65536, size_t slotSize = 256);
+
+    /**   :        (rdtsc  
+     * TSC,  CLOCK_MONOTONIC_COARSE   ),       
+     *    ,      .    .
+     *      5 .
+     * @param enabled - true -  , false -     
+    */
+    void setFastTimestamps(bool enabled);
+
+    /**    :      LZ4  zstd
+     * (   ".lz4"  ".zst").        
+     *   ,         .
+     *   ,   . zstd    -DLOG_USE_ZSTD -lzstd,
+     *   LZ4.
+     * @param codec - ; LogCompression::none -  
+     * @param blockSize -   .  : 1 
+     * @param level -   (zstd 1..19, LZ4 1..6).  : 1
+    */
+    void setCompression(LogCompression codec, size_t blockSize = 1 << 20, int level = 1);
+
+    /**     :  "<>.idx"   interval  
+     *  ,         .  
+     * log_query     ,    .
+     *    ,   .    .
+     * @param interval -    ; 0 -   .  : 1024
+    */
+    void setIndex(unsigned interval = 1024);
+
+    /**     (,     Windows-1251,
+     *     UTF-8).       ;
+     *    ASCII-  .      .
+     * : setEncoding(LogEncoding::cp1251, LogEncoding::utf8)
+     * @param from -  
+     * @param to -      . LogEncoding::none -  
+    */
+    void setEncoding(LogEncoding from, LogEncoding to);
+
+    /**    ,     ()
+     * @param level - 
+     * @param rate -   0 ()  1 ().  0.01 -  1% 
+    */
+    void setSampling(Severity level, double rate);
+
+    /**  :        
+     *   (   error -   ),   -  .
+     * :    highDepth     maxLatencyMs.
+     * :   lowDepth    maxLatencyMs / 2   .
+     * @param enabled -   
+     * @param highDepth -   (),    .  : 100000
+     * @param lowDepth - ,    .  : 10000
+     * @param maxLatencyMs -     , .  : 200
+    */
+    void setAdaptive(bool enabled, size_t highDepth = 100000, size_t lowDepth = 10000, int maxLatencyMs = 200);
+
+    /**    
+     * @return   (  )
+    */
+    Stats getStats();
+
+    /**      LOG_SAMPLED: ": kept=N dropped=M"     */
+    static string getCallSiteStats();
+
+    /**       (  LOG_SAMPLED).
+     *         (setSampling).
+     * @param site -  
+     * @param level - 
+     * @param text - 
+    */
+    template <typename T>
+    void writeSampled(CallSite& site, Severity level, T text);
+
+    /** /      LOG_METRIC (LOGI_COUNT, LOGI_VALUE ...).
+     *                :
+     * "<> [metric] count=N rate=R/s",       "min=A avg=B max=C".
+     *       ;      .
+     *    .
+     * @param enabled - true - , false -   
+     * @param intervalMs -  , .  : 10000
+     * @param filename -   ,   write().  : "" (  )
+    */
+    void setMetrics(bool enabled, int intervalMs = 10000, const string& filename = "");
+
+    /**  - (  LOG_METRIC)
+     * @param site -  
+     * @param value -  (,  )
+     * @param hasValue -   
+    */
+    void writeMetric(MetricSite& site, long long value, bool hasValue);
+
+    /**      (, NetworkSink).
+     *    ,       .
+     * Logs        .
+     * @param sink - 
+     * @param exclusive - true -      ,   .
+     *  : false
+    */
+    void addSink(LogSink* sink, bool exclusive = false);
+
+    /**        (,  , ).
+     *    ,     ;
+     *      (. Subscription::dropped),    .
+     * : auto sub = log->subscribe(Logs::Filter(Logs::Severity::warning, "net", "timeout"));
+     * @param filter -  ;  -   ,   write()
+     * @param capacity -     .  : 4096
+     * @return  (  unsubscribe)
+    */
+    shared_ptr<Subscription> subscribe(const Filter& filter = Filter(), size_t capacity = 4096);
+
+    /**  ; ,     ,  
+     * @param subscription - 
+    */
+    void unsubscribe(const shared_ptr<Subscription>& subscription);
+
+    /**   :    (SIGSEGV, SIGABRT, std::terminate  ..)
+     *          async-signal-safe ,
+     *        ,    .
+     * @param crashFile -       .  : "" (stderr)
+    */
+    void installCrashHandler(const string& crashFile = "");
+
+    /**      ,    (  )  .
+     *      .
+    */
+    void flush();
+
+    /**  :     fdatasync  .
+     *       : ,     , 
+     *   ( ); ,  write(),  .   
+     * fdatasync       ( periodic -      
+     * ); ,   ,    fdatasync.   - sync()  LOGE_SYNC.    .
+     * @param mode - Durability::none, on_error (    )  periodic
+     * @param intervalMs -  periodic:    fdatasync, .  : 100
+    */
+    void setDurability(Durability mode, int intervalMs = 100);
+
+    /**     (fdatasync)  ,   .
+     * ,  sync() ,    fdatasync.
+     *      .
+    */
+    void sync();
+
+    /**     ( LOGE_SYNC): write(),  sync().
+     *       ,  fdatasync    (  
+     *  ). ,     (setSharedRing),   fdatasync
+     *  -;    ,      .
+     *    write()
+    */
+    template <typename T>
+    void writeDurable(Severity level, T text, string filename = "", string sourcefile = "", int sourceline = -1);
+
+    /**      :  flush(),   - Completion
+     * (  then()  co_await),    .
+    */
+    Completion flushAsync() {
+        return Completion(this, false);
+    }
+
+    /**      :  sync(),   - Completion.
+     *      fdatasync   sync().
+    */
+    Completion syncAsync() {
+        return Completion(this, true);
     }
 
+    /**      ( LOGE_DURABLE): write(),  syncAsync().
+     *    fdatasync  ,  Completion  . , 
+     *   ,    ,   writeDurable:   
+     * ,     .
+     *    write()
+    */
+    template <typename T>
+    Completion writeDurableAsync(Severity level, T text, string filename = "", string sourcefile = "", int sourceline = -1);
+
     /**    
      * @param level -    
     */
-    void setLevel(Severity level) {
-        m_level = level;
-    }
+    void setLevel(Severity level);
 
     /**    
      * @param format -   
     */
-    void setFormat(string format) {
-        m_format = format;
-    }
+    void setFormat(string format);
+
+    /**      .
+     * : setFormat(LOG_FORMAT("{t} | {L} -> {m}")) -      
+     * @param format -  
+    */
+    void setFormat(const LogFormat& format);
 
     /**      */
-    void setFormat() {
-        m_format = "";
-    }
+    void setFormat();
 
     /**   
      * @param level -     
-     * @param text -   ,     (, )
+     * @param text -  : string, const char*  char* (     logs.cpp)
      * @param filename -    .      . 
      *  .  : "". 
      * @param sourcefile - -,    . 
@@ -107,25 +623,7 @@ public:
      * : (src/main.cpp:45).  .  : "". 
     */
     template <typename T>
-    void write(Severity level, T text, string filename = "", string sourcefile = "", int sourceline = -1) {
-        if (level < m_level) return; //     INFO,   TRACE  DEBUG . 
-        lock_guard<mutex> lock(mutex); //    ,     
-        switch (m_out) {
-            case only_console:
-                writeConsole(level, text, sourcefile, sourceline);
-                break;
-            case only_file:
-                writeFile(level, text, filename, sourcefile, sourceline);
-                break;
-            case file_and_console:
-                writeConsole(level, text, sourcefile, sourceline);
-                writeFile(level, text, filename, sourcefile, sourceline);
-                break;
-            default:
-                writeConsole(level, text, sourcefile, sourceline);
-                break;    
-        };
-    }
+    void write(Severity level, T text, string filename = "", string sourcefile = "", int sourceline = -1);
     /**     
      * @param level -     
      * @param text -   ,     (, )
@@ -133,9 +631,7 @@ public:
      * @param sourceline -    -,    .
     */
     template <typename T>
-    void writeConsole(Severity& level, T& text, string& sourcefile, int& sourceline) {
-        cout << getResultedString(level, text, sourcefile, sourceline) << endl;
-    }
+    void writeConsole(Severity& level, T& text, string& sourcefile, int& sourceline);
 
     /**    
      * @param level -     
@@ -145,108 +641,56 @@ public:
      * @param sourceline -    -,    .
     */
     template <typename T>
-    void writeFile(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline) {
-        string datetime = getDatetime("%Y-%m-%d_%X");
-        if (filename.length() == 0 || filename == "") {
-            while (datetime.find(':') != std::string::npos) {
-                datetime.replace(datetime.find(':'), 1, "-");
-            }
-            filename = "log_" + datetime + ".log";
-        }
-        else if (filename.find(".log") == std::string::npos) {
-            filename += ".log";
-        }
-        
-        ofstream file(filename);
-        if (file.is_open()) {
-            file << getResultedString(level, text, sourcefile, sourceline) << endl;
-        }
-        else {
-            cout << ":    .\n" << endl;
-            return;
-        }
-        file.close();
-    }
+    void writeFile(Severity& level, T& text, string& filename, string& sourcefile, int& sourceline);
 
     /**     ( )
      * @return ,   "yyyy-mm-dd hh:mm:ss"
     */
-    string getDatetime() {
-        time_t time_now = time(0);
-        char timeString[80];
-        strftime(timeString, sizeof(timeString), "%Y-%m-%d %X", localtime(&time_now));
-        return timeString;
-    }
+    string getDatetime();
+
+    /**     
+     * @param time_now -    
+     * @return ,   "yyyy-mm-dd hh:mm:ss"
+    */
+    string getDatetime(time_t time_now);
 
     /**       
      * @return ,   "yyyy-mm-dd*hh:mm:ss",  * -  
      * https://en.cppreference.com/w/cpp/chrono/c/strftime -    
     */
-    string getDatetime(string format) {
-        time_t time_now = time(0);
-        char timeString[80];
-        strftime(timeString, sizeof(timeString), format.data(), localtime(&time_now));
-        return timeString;
-    }
+    string getDatetime(string format);
 
     
     /**      
      * @param level -  ,      
      * @return     
     */
-    string getLevel(Severity& level) {
-        switch (level)
-        {
-        case Severity::trace:
-            return "TRACE";
-            break;
-        case Severity::debug:
-            return "DEBUG";
-            break;
-        case Severity::info:
-            return "INFO";
-            break;
-        case Severity::warning:
-            return "WARNING";
-            break;
-        case Severity::error:
-            return "ERROR";
-            break;
-        default:
-            return "???";
-            break;
-        }
-    }
+    string getLevel(Severity& level);
 
     /**    ,    
      *  {t} | {L} -> {m}   2023-09-22 12:10:00 | INFO -> User logged out. 
      *  {t} | {L} | {S}:{l} -> {m}   2023-09-22 12:10:00 | INFO | src/main.cpp:45 -> User logged out. 
+     *  {t} [{ctx}] {m}   2023-09-22 12:10:00 [req=42 user=alice] User logged out. 
      * @param level -  ,      
      * @param text -   ,     (, )
      * @param sourcefile - -,    . 
      * @param sourceline -    -,    .
+     * @param when -   .  :  
+     * @param context -    {ctx}.  : nullptr (  )
+     * @param messageAt -       (    ).  : nullptr
+     * @param format -  .  : nullptr ( , . setFormat)
      * @return  
     */
     template <typename T>
-    string getResultedString(Severity& level, T& text, string& sourcefile, int& sourceline) {
-        UsefulFunctions us;
-        if (m_format.length() == 0 || m_format == "") {
-            return (getDatetime() + " | " + getLevel(level) + ((sourcefile.length() == 0 || sourcefile == "") ? "" : " | " + sourcefile)  + ((sourceline > 0) ? " | line:" + us.toString(sourceline) : "") + " -> " + text);
-        }
-        else {
-            string str_form = m_format;  
-            if (m_format.find("{t}") != string::npos) str_form.replace(m_format.find("{t}"), 3, getDatetime()); // time
-            if (m_format.find("{L}") != string::npos) str_form.replace(m_format.find("{L}"), 3, getLevel(level)); // level
-            if (m_format.find("{m}") != string::npos)  str_form.replace(m_format.find("{m}"), 3, text); // message
-            if (m_format.find("{S}") != string::npos)  str_form.replace(m_format.find("{S}"), 3, "src/" + sourcefile); // src file
-            if (m_format.find("{l}") != string::npos)  str_form.replace(m_format.find("{l}"), 3, us.toString(sourceline)); // line in src file
-            return str_form;
-        }
-    }
-};
+    string getResultedString(Severity& level, T& text, string& sourcefile, int& sourceline, time_t when = time(0), 
+        const string* context = nullptr, size_t* messageAt = nullptr, const LogFormat* format = nullptr);
+
+private:
+    /**  :  ,     (. Logs::Impl  logs.cpp) */
+    Impl* m_impl;
 
-//   
-Logs* Logs::m_instance = nullptr;
-mutex Logs::m_mtx;
+    /**    Completion (. Impl::addCompletion) */
+    bool addCompletion(bool durable, function<void()> done);
+};
 
 #endif //STORE_H
\ No newline at end of file
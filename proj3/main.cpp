@@ -2,8 +2,14 @@
 #include <windows.h>
 #include "logs.h" // 
 
+// LogContext        
+static_assert(is_constructible<LogContext, const char*, uint64_t>::value, "LogContext: uint64_t");
+static_assert(is_constructible<LogContext, const char*, size_t>::value, "LogContext: size_t");
+static_assert(is_constructible<LogContext, const char*, long>::value, "LogContext: long");
+
 int main(int argc, char** argv) {
 
+	LogContext task("task", (uint64_t)GetCurrentProcessId()); //   {ctx}
 	LOGI("Task started.");
 	Logs log;
 	log.write(Logs::Severity::error, "xd", "test.log"); // file_and_console